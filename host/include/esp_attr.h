@@ -0,0 +1,10 @@
+#ifndef _SIM_ESP_ATTR_H_
+#define _SIM_ESP_ATTR_H_
+
+//memory placement means nothing on the host
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif
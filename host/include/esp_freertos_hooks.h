@@ -0,0 +1,12 @@
+#ifndef _SIM_ESP_FREERTOS_HOOKS_H_
+#define _SIM_ESP_FREERTOS_HOOKS_H_
+
+#include "esp_err.h"
+
+typedef void (*esp_freertos_tick_cb_t)(void);
+
+//called from the simulated tick interrupt of "cpuid"
+esp_err_t esp_register_freertos_tick_hook_for_cpu(esp_freertos_tick_cb_t new_tick_cb, int cpuid);
+esp_err_t esp_register_freertos_tick_hook(esp_freertos_tick_cb_t new_tick_cb);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef _SIM_ESP_INTR_ALLOC_H_
+#define _SIM_ESP_INTR_ALLOC_H_
+
+#define ESP_INTR_FLAG_LEVEL1    (1 << 1)
+#define ESP_INTR_FLAG_SHARED    (1 << 8)
+#define ESP_INTR_FLAG_EDGE      (1 << 9)
+#define ESP_INTR_FLAG_IRAM      (1 << 10)
+
+typedef struct intr_handle_data_t *intr_handle_t;
+
+#endif
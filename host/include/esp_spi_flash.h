@@ -0,0 +1,6 @@
+#ifndef _SIM_ESP_SPI_FLASH_H_
+#define _SIM_ESP_SPI_FLASH_H_
+
+#define SPI_FLASH_SEC_SIZE 4096
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef _SIM_ESP_SYSTEM_H_
+#define _SIM_ESP_SYSTEM_H_
+
+#include <stdint.h>
+
+//pseudo random, same sequence every run so runs stay identical
+uint32_t esp_random(void);
+
+#endif
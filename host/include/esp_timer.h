@@ -0,0 +1,9 @@
+#ifndef _SIM_ESP_TIMER_H_
+#define _SIM_ESP_TIMER_H_
+
+#include <stdint.h>
+
+//virtual microseconds since boot
+int64_t esp_timer_get_time(void);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef _SIM_FREERTOS_H_
+#define _SIM_FREERTOS_H_
+
+//FreeRTOS as seen by main/, implemented on the host simulator (sim/simRtos.c)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_FULL 0
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(((TickType_t)(ms) * configTICK_RATE_HZ) / 1000))
+
+#ifdef CONFIG_FREERTOS_UNICORE
+#define portNUM_PROCESSORS 1
+#else
+#define portNUM_PROCESSORS 2
+#endif
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define configMAX_PRIORITIES 25
+
+//no real interrupts or second core on the host, so these are nothing. Tests
+//built with FAKE_IRQ play an interrupt with a signal, and mask it here
+//(tests/fakeRtos.c).
+typedef struct { uint32_t owner; uint32_t count; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED { 0, 0 }
+#ifdef FAKE_IRQ
+void fakeIrqOff(void);
+void fakeIrqOn(void);
+#define portENTER_CRITICAL(mux) ((void)(mux), fakeIrqOff())
+#define portEXIT_CRITICAL(mux) ((void)(mux), fakeIrqOn())
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux), fakeIrqOff())
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux), fakeIrqOn())
+#define portENTER_CRITICAL_SAFE(mux) ((void)(mux), fakeIrqOff())
+#define portEXIT_CRITICAL_SAFE(mux) ((void)(mux), fakeIrqOn())
+#else
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux))
+#define portEXIT_CRITICAL_ISR(mux) ((void)(mux))
+#define portENTER_CRITICAL_SAFE(mux) ((void)(mux))
+#define portEXIT_CRITICAL_SAFE(mux) ((void)(mux))
+#endif
+#define portYIELD_FROM_ISR() do{}while(0)
+
+BaseType_t xPortGetCoreID(void);
+BaseType_t xPortInIsrContext(void);
+
+#endif
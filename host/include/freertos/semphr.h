@@ -0,0 +1,17 @@
+#ifndef _SIM_SEMPHR_H_
+#define _SIM_SEMPHR_H_
+
+//semaphores are queues of zero sized items, as in FreeRTOS. No priority inheritance.
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+#define xSemaphoreCreateBinary() xQueueCreate(1, 0)
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+#define xSemaphoreTake(s, ticks) xQueueReceive((s), NULL, (ticks))
+#define xSemaphoreGive(s) xQueueSend((s), NULL, 0)
+#define xSemaphoreGiveFromISR(s, woken) xQueueSendFromISR((s), NULL, (woken))
+#define vSemaphoreDelete(s) vQueueDelete(s)
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef _SIM_CORE_MACROS_H_
+#define _SIM_CORE_MACROS_H_
+
+//CPU cycle counter, made from virtual time at the configured CPU clock
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+uint64_t simNow(void);
+
+#define XTHAL_GET_CCOUNT() ((uint32_t)(simNow() * CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ))
+
+#endif
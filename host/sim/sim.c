@@ -0,0 +1,247 @@
+//Deterministic run-to-block simulator for the firmware in main/.
+//
+//Timing model:
+// - time is a virtual microsecond counter. It only moves when every task is
+//   blocked, so code costs zero time and a run is fully reproducible.
+// - tasks are ucontext coroutines on one host thread. The highest priority
+//   ready task runs; equal priorities take turns in the order they became ready.
+//   Waking a higher priority task from task context switches to it at once,
+//   like FreeRTOS preemption. There is one timeline, cores only matter for
+//   xPortGetCoreID().
+// - timer alarms and input pulses are simEvent_t's. They fire in "ISR context"
+//   when time reaches them, before any task woken at the same instant runs.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "sdkconfig.h"
+#include "esp_system.h"
+#include "sim.h"
+
+#define SIM_STACK_MIN (256 * 1024)     //host code, printf etc. need far more than xtensa
+
+enum { T_READY, T_RUNNING, T_BLOCKED, T_DELETED };
+
+struct simTask {
+    char name[16];
+    void (*fn)(void *);
+    void *param;
+    int prio;
+    int core;
+    int state;
+    ucontext_t ctx;
+    void *stack;
+    uint64_t wakeAt;
+    const void *waitObj;
+    bool woken;
+    uint64_t order;
+    uint32_t notify;
+    uint32_t runs;
+    simTask_t *next;
+};
+
+static uint64_t now;
+static bool inIsr;
+static int isrCore;
+static ucontext_t schedCtx;
+static simTask_t *tasks, *current;
+static simEvent_t *events;
+static uint64_t orderCtr;
+static simStats_t stats;
+
+bool simLogOn = true;
+
+uint64_t simNow(void){ return now; }
+uint64_t simTickUs(void){ return 1000000 / CONFIG_FREERTOS_HZ; }
+bool simInIsr(void){ return inIsr; }
+uint32_t esp_random(void){
+    static uint32_t x = 2463534242u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+int simCoreId(void){
+    if(inIsr) return isrCore;
+    return (current && current->core > 0) ? current->core : 0;
+}
+simTask_t *simTaskCurrent(void){ return current; }
+const char *simTaskName(simTask_t *t){ return t->name; }
+int simTaskPrio(simTask_t *t){ return t->prio; }
+uint32_t *simTaskNotifyWord(simTask_t *t){ return &t->notify; }
+
+void simGetStats(simStats_t *st){ *st = stats; }
+
+//---------------------------- events -----------------------------
+void simEventArm(simEvent_t *ev, uint64_t at){
+    if(!ev->listed){
+        ev->listed = true;
+        ev->next = events;
+        events = ev;
+    }
+    ev->at = at < now ? now : at;
+    ev->armed = true;
+}
+
+void simEventDisarm(simEvent_t *ev){
+    ev->armed = false;
+}
+
+//earliest armed event, ties go to the one registered first (end of list)
+static simEvent_t *nextEvent(void){
+    simEvent_t *best = NULL;
+    for(simEvent_t *ev = events; ev; ev = ev->next){
+        if(ev->armed && (best == NULL || ev->at <= best->at)) best = ev;
+    }
+    return best;
+}
+
+//---------------------------- tasks -----------------------------
+static void makeReady(simTask_t *t, bool woken){
+    t->state = T_READY;
+    t->woken = woken;
+    t->waitObj = NULL;
+    t->wakeAt = SIM_NEVER;
+    t->order = ++orderCtr;
+}
+
+static void trampoline(void){
+    current->fn(current->param);
+    //FreeRTOS tasks must never return, but be kind
+    simTaskDelete(NULL);
+}
+
+simTask_t *simTaskCreate(void (*fn)(void *), const char *name, uint32_t stackBytes,
+                         void *param, int prio, int core){
+    simTask_t *t = calloc(1, sizeof(*t));
+    simTask_t **end = &tasks;
+
+    strncpy(t->name, name, sizeof(t->name) - 1);
+    t->fn = fn;
+    t->param = param;
+    t->prio = prio;
+    t->core = core;
+    if(stackBytes < SIM_STACK_MIN) stackBytes = SIM_STACK_MIN;
+    t->stack = malloc(stackBytes);
+
+    getcontext(&t->ctx);
+    t->ctx.uc_stack.ss_sp = t->stack;
+    t->ctx.uc_stack.ss_size = stackBytes;
+    t->ctx.uc_link = &schedCtx;
+    makecontext(&t->ctx, trampoline, 0);
+
+    while(*end) end = &(*end)->next;    //keep creation order, it breaks ties
+    *end = t;
+    makeReady(t, false);
+
+    if(current && !inIsr && prio > current->prio) simYield();
+    return t;
+}
+
+void simTaskDelete(simTask_t *t){
+    if(t == NULL) t = current;
+    t->state = T_DELETED;
+    if(t == current) swapcontext(&t->ctx, &schedCtx);
+}
+
+void simYield(void){
+    simTask_t *me = current;
+    if(me == NULL || inIsr) return;
+    makeReady(me, false);
+    swapcontext(&me->ctx, &schedCtx);
+}
+
+bool simBlock(const void *obj, uint64_t wakeAt){
+    simTask_t *me = current;
+    me->state = T_BLOCKED;
+    me->waitObj = obj;
+    me->wakeAt = wakeAt;
+    me->woken = false;
+    swapcontext(&me->ctx, &schedCtx);
+    return me->woken;
+}
+
+void simWake(simTask_t *t){
+    if(t->state != T_BLOCKED) return;
+    makeReady(t, true);
+    if(current && !inIsr && t->prio > current->prio) simYield();
+}
+
+void simWakeAll(const void *obj){
+    bool preempt = false;
+    for(simTask_t *t = tasks; t; t = t->next){
+        if(t->state == T_BLOCKED && t->waitObj == obj){
+            makeReady(t, true);
+            if(current && t->prio > current->prio) preempt = true;
+        }
+    }
+    if(preempt && !inIsr) simYield();
+}
+
+static simTask_t *pickReady(void){
+    simTask_t *best = NULL;
+    for(simTask_t *t = tasks; t; t = t->next){
+        if(t->state != T_READY) continue;
+        if(best == NULL || t->prio > best->prio || (t->prio == best->prio && t->order < best->order)) best = t;
+    }
+    return best;
+}
+
+//---------------------------- scheduler -----------------------------
+void simRun(uint64_t untilUs){
+    while(1){
+        simTask_t *t = pickReady();
+        if(t){
+            current = t;
+            t->state = T_RUNNING;
+            t->runs++;
+            stats.switches++;
+            swapcontext(&schedCtx, &t->ctx);
+            if(t->state == T_RUNNING) t->state = T_DELETED;   //returned through uc_link
+            current = NULL;
+            continue;
+        }
+
+        //everybody is blocked: jump to the next thing that happens
+        uint64_t next = SIM_NEVER;
+        simEvent_t *ev = nextEvent();
+        if(ev) next = ev->at;
+        for(t = tasks; t; t = t->next){
+            if(t->state == T_BLOCKED && t->wakeAt < next) next = t->wakeAt;
+        }
+        if(next == SIM_NEVER || next > untilUs){
+            now = untilUs;
+            return;
+        }
+        now = next;
+
+        while((ev = nextEvent()) && ev->at <= now){
+            ev->armed = false;
+            ev->fired++;
+            stats.isrs++;
+            inIsr = true;
+            isrCore = ev->core;
+            ev->fn(ev->arg);
+            inIsr = false;
+        }
+        for(t = tasks; t; t = t->next){
+            if(t->state == T_BLOCKED && t->wakeAt <= now) makeReady(t, false);
+        }
+    }
+}
+
+void simPrintSummary(void){
+    printf("tasks:\n");
+    for(simTask_t *t = tasks; t; t = t->next){
+        printf("  %-16s prio %2d core %2d runs %10u%s\n", t->name, t->prio, t->core,
+               t->runs, t->state == T_DELETED ? "  (deleted)" : "");
+    }
+    printf("isr events:\n");
+    for(simEvent_t *ev = events; ev; ev = ev->next){
+        printf("  %-16s fired %10u\n", ev->name ? ev->name : "?", ev->fired);
+    }
+    printf("context switches %llu, isrs %llu\n",
+           (unsigned long long)stats.switches, (unsigned long long)stats.isrs);
+}
@@ -0,0 +1,89 @@
+#ifndef _SIM_H_
+#define _SIM_H_
+
+//Virtual clock, cooperative task scheduler and timed events behind the fake
+//ESP-IDF headers in host/include. See sim.c for the timing model.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_NEVER UINT64_MAX
+
+typedef struct simTask simTask_t;
+
+//something that happens at a virtual time and runs in "ISR context"
+typedef struct simEvent {
+    uint64_t at;
+    void (*fn)(void *arg);
+    void *arg;
+    const char *name;
+    int core;               //core whose "ISR" this is
+    bool armed;
+    bool listed;
+    uint32_t fired;
+    struct simEvent *next;
+} simEvent_t;
+
+//virtual time in microseconds since boot
+uint64_t simNow(void);
+uint64_t simTickUs(void);
+bool simInIsr(void);
+int simCoreId(void);
+
+void simEventArm(simEvent_t *ev, uint64_t at);
+void simEventDisarm(simEvent_t *ev);
+
+//tasks. prio as FreeRTOS, core -1 = either core
+simTask_t *simTaskCreate(void (*fn)(void *), const char *name, uint32_t stackBytes,
+                         void *param, int prio, int core);
+simTask_t *simTaskCurrent(void);
+void simTaskDelete(simTask_t *t);
+const char *simTaskName(simTask_t *t);
+int simTaskPrio(simTask_t *t);
+
+//block the running task until simWake() or until "wakeAt" (SIM_NEVER = forever).
+//"obj" is what it waits on, for simWakeAll(). True if woken, false on timeout.
+bool simBlock(const void *obj, uint64_t wakeAt);
+void simWake(simTask_t *t);
+void simWakeAll(const void *obj);
+void simYield(void);
+
+//notification word of a task, used by the ulTaskNotify... family
+uint32_t *simTaskNotifyWord(simTask_t *t);
+
+//run until virtual time "untilUs" or until nothing is left to do
+void simRun(uint64_t untilUs);
+
+//counters for the summary
+typedef struct {
+    uint64_t switches;
+    uint64_t isrs;
+} simStats_t;
+void simGetStats(simStats_t *st);
+void simPrintSummary(void);
+
+//gpio side of the simulation, see simGpio.c
+typedef void (*simGpioTraceFn)(int pin, int level, uint64_t atUs);
+void simGpioTrace(simGpioTraceFn fn);
+void simGpioPulse(int pin, uint32_t hz);      //square wave into an input pin, 0 = stop
+uint32_t simGpioEdges(int pin);
+void simGpioSummary(void);
+
+//flash side, see simFlash.c
+typedef struct {
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t erases;
+} simFlashStats_t;
+void simFlashImage(const char *path);       //load at the first access, save at the end
+void simFlashCut(uint32_t op);              //lose power during the op-th write or erase
+void simFlashSave(void);
+void simFlashSummary(void);
+
+//uart side, see simUart.c
+void simUartFile(int port, const char *path);   //save what the firmware sends
+void simUartSummary(void);
+
+extern bool simLogOn;
+
+#endif
@@ -0,0 +1,128 @@
+//Flash partitions on the simulator: a RAM image with NOR rules (a write can only
+//clear bits, an erase sets a sector to 0xff), optionally loaded from and saved
+//to a file so the next run boots on what this one left behind.
+//
+//simFlashCut(n) pulls the plug during the n-th write or erase: that operation
+//is only half done, the image is saved and the simulator exits with code 2.
+//Run it in a loop with different n to torture the logs.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_partition.h"
+#include "esp_spi_flash.h"
+#include "sim.h"
+
+//keep in line with partitions.csv
+static esp_partition_t parts[] = {
+    { ESP_PARTITION_TYPE_DATA, 0x40, 0x110000, 0x10000, "flowlog", false },
+};
+#define SIM_NUM_PARTS (sizeof(parts) / sizeof(parts[0]))
+#define SIM_FLASH_BASE 0x110000
+#define SIM_FLASH_SIZE 0x10000
+
+static uint8_t image[SIM_FLASH_SIZE];
+static bool imageReady;
+static const char *imagePath;
+static uint32_t cutAt;              //0 = never
+static simFlashStats_t fst;
+
+static void imageInit(void){
+    FILE *f;
+
+    if(imageReady) return;
+    imageReady = true;
+    memset(image, 0xff, sizeof(image));
+    if(imagePath && (f = fopen(imagePath, "rb")) != NULL){
+        if(fread(image, 1, sizeof(image), f) != sizeof(image)) memset(image, 0xff, sizeof(image));
+        fclose(f);
+    }
+}
+
+void simFlashImage(const char *path){
+    imagePath = path;
+}
+
+void simFlashCut(uint32_t op){
+    cutAt = op;
+}
+
+void simFlashSave(void){
+    FILE *f;
+
+    if(!imagePath || !imageReady) return;
+    if((f = fopen(imagePath, "wb")) == NULL){
+        printf("can't write flash image %s\n", imagePath);
+        return;
+    }
+    fwrite(image, 1, sizeof(image), f);
+    fclose(f);
+}
+
+//true if the power goes out during this operation
+static bool powerCut(void){
+    return cutAt && fst.writes + fst.erases == cutAt;
+}
+
+static void powerOff(const char *what, size_t addr){
+    printf("---- power cut during flash %s at 0x%06zx, %.3f s\n", what, addr, simNow() / 1e6);
+    simFlashSave();
+    exit(2);
+}
+
+static uint8_t *at(const esp_partition_t *p, size_t off, size_t size){
+    imageInit();
+    if(p < parts || p >= parts + SIM_NUM_PARTS || off + size > p->size || off + size < off) return NULL;
+    return &image[p->address - SIM_FLASH_BASE + off];
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type,
+                                                esp_partition_subtype_t subtype, const char *label){
+    for(size_t i = 0; i < SIM_NUM_PARTS; i++){
+        if(parts[i].type != type) continue;
+        if(subtype != ESP_PARTITION_SUBTYPE_ANY && parts[i].subtype != subtype) continue;
+        if(label && strcmp(parts[i].label, label) != 0) continue;
+        return &parts[i];
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size){
+    uint8_t *src = at(partition, src_offset, size);
+
+    if(!src) return ESP_ERR_INVALID_ARG;
+    memcpy(dst, src, size);
+    fst.reads++;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size){
+    uint8_t *dst = at(partition, dst_offset, size);
+    const uint8_t *s = src;
+    bool cut;
+
+    if(!dst) return ESP_ERR_INVALID_ARG;
+    fst.writes++;
+    cut = powerCut();
+    if(cut) size /= 2;
+    for(size_t i = 0; i < size; i++) dst[i] &= s[i];
+    if(cut) powerOff("write", partition->address + dst_offset);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size){
+    uint8_t *dst = at(partition, offset, size);
+    bool cut;
+
+    if(!dst || offset % SPI_FLASH_SEC_SIZE || size % SPI_FLASH_SEC_SIZE) return ESP_ERR_INVALID_ARG;
+    fst.erases++;
+    cut = powerCut();
+    memset(dst, 0xff, cut ? size / 2 : size);
+    if(cut) powerOff("erase", partition->address + offset);
+    return ESP_OK;
+}
+
+void simFlashSummary(void){
+    printf("flash: %llu reads, %llu writes, %llu erases\n", (unsigned long long)fst.reads,
+           (unsigned long long)fst.writes, (unsigned long long)fst.erases);
+}
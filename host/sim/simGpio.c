@@ -0,0 +1,126 @@
+//GPIO pins on the simulator: outputs are recorded, inputs can be fed a pulse train
+
+#include <stddef.h>
+#include <stdio.h>
+#include "driver/gpio.h"
+#include "sim.h"
+
+typedef struct {
+    gpio_mode_t mode;
+    int level;
+    gpio_int_type_t intr;
+    gpio_isr_t isr;
+    void *arg;
+    uint32_t edges;
+    uint32_t halfUs;        //input pulse train, half period
+    simEvent_t pulse;
+    char name[12];
+} simPin_t;
+
+static simPin_t pins[GPIO_NUM_MAX];
+static simGpioTraceFn traceFn;
+
+static bool badPin(gpio_num_t n){
+    return (unsigned)n >= GPIO_NUM_MAX;
+}
+
+//level change on any pin, from the firmware or from a pulse train
+static void setLevel(int n, int level){
+    simPin_t *p = &pins[n];
+    level = level ? 1 : 0;
+    if(level == p->level) return;
+    p->level = level;
+    p->edges++;
+    if(traceFn) traceFn(n, level, simNow());
+
+    if(p->isr == NULL) return;
+    if(p->intr == GPIO_INTR_ANYEDGE ||
+       (p->intr == GPIO_INTR_POSEDGE && level) ||
+       (p->intr == GPIO_INTR_NEGEDGE && !level)) p->isr(p->arg);
+}
+
+void gpio_pad_select_gpio(uint8_t gpio_num){
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode){
+    if(badPin(gpio_num)) return ESP_ERR_INVALID_ARG;
+    pins[gpio_num].mode = mode;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level){
+    if(badPin(gpio_num)) return ESP_ERR_INVALID_ARG;
+    if(pins[gpio_num].mode & GPIO_MODE_OUTPUT) setLevel(gpio_num, level);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num){
+    if(badPin(gpio_num)) return 0;
+    return pins[gpio_num].level;
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull){
+    if(badPin(gpio_num)) return ESP_ERR_INVALID_ARG;
+    if(pull == GPIO_PULLUP_ONLY && pins[gpio_num].halfUs == 0) pins[gpio_num].level = 1;
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_intr_type(gpio_num_t gpio_num, gpio_int_type_t intr_type){
+    if(badPin(gpio_num)) return ESP_ERR_INVALID_ARG;
+    pins[gpio_num].intr = intr_type;
+    return ESP_OK;
+}
+
+esp_err_t gpio_install_isr_service(int intr_alloc_flags){
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t gpio_num, gpio_isr_t isr_handler, void *args){
+    if(badPin(gpio_num)) return ESP_ERR_INVALID_ARG;
+    pins[gpio_num].isr = isr_handler;
+    pins[gpio_num].arg = args;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t gpio_num){
+    if(badPin(gpio_num)) return ESP_ERR_INVALID_ARG;
+    pins[gpio_num].isr = NULL;
+    return ESP_OK;
+}
+
+//---------------------------- simulation side -----------------------------
+static void pulseEdge(void *arg){
+    simPin_t *p = arg;
+    setLevel(p - pins, !p->level);
+    if(p->halfUs) simEventArm(&p->pulse, simNow() + p->halfUs);
+}
+
+void simGpioPulse(int pin, uint32_t hz){
+    simPin_t *p = &pins[pin];
+    p->halfUs = hz ? 500000 / hz : 0;
+    if(p->halfUs == 0){
+        simEventDisarm(&p->pulse);
+        return;
+    }
+    snprintf(p->name, sizeof(p->name), "gpio%d in", pin);
+    p->pulse.name = p->name;
+    p->pulse.fn = pulseEdge;
+    p->pulse.arg = p;
+    simEventArm(&p->pulse, simNow() + p->halfUs);
+}
+
+void simGpioTrace(simGpioTraceFn fn){
+    traceFn = fn;
+}
+
+uint32_t simGpioEdges(int pin){
+    return pins[pin].edges;
+}
+
+void simGpioSummary(void){
+    printf("gpio edges:\n");
+    for(int i = 0; i < GPIO_NUM_MAX; i++){
+        if(pins[i].edges) printf("  gpio%-2d %s %10u\n", i,
+                                 (pins[i].mode & GPIO_MODE_OUTPUT) ? "out" : "in ", pins[i].edges);
+    }
+}
@@ -0,0 +1,131 @@
+//g02sim: boot the firmware's app_main() on the virtual clock and run it for a while
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "flowMeter.h"
+#include "flowTotal.h"
+#include "outSched.h"
+#include "perfStats.h"
+#include "taskTable.h"
+#include "sim.h"
+
+#define SIM_FLOW_PIN 4      //matches FLOWpin in flowMeter.c
+
+void app_main(void);
+
+//same as the IDF main task: app_main runs in a task, on core 0, priority 1
+static void mainTask(void *arg){
+    app_main();
+    vTaskDelete(NULL);
+}
+
+//extra output channels for -o, each with its own pattern so the edges spread out
+static int benchCh;
+
+static void benchTask(void *arg){
+    vTaskDelay(10 / portTICK_PERIOD_MS);        //after app_main's setup
+    for(int i = 1; i < benchCh; i++){
+        int ch = outAdd(GPIO_NUM_NC, i % 4, NULL);
+        outPlay(ch, &(blinkReq_t){
+            .count = 1 + i % 4,
+            .onUs = 3000 + 1000 * (i % 7) + 13 * i,
+            .offUs = 5000 + 700 * (i % 5) + 29 * i,
+            .gapUs = 20000,
+            .repeat = 1000000000,
+        });
+    }
+    vTaskDelete(NULL);
+}
+
+static void traceEdge(int pin, int level, uint64_t atUs){
+    printf("%llu.%06llu gpio%d %d\n", (unsigned long long)(atUs / 1000000),
+           (unsigned long long)(atUs % 1000000), pin, level);
+}
+
+static void usage(const char *me){
+    printf("usage: %s [-t seconds] [-f flowHz] [-F image] [-k op] [-o channels] [-u file] [-e] [-q] [-p] [-c]\n"
+           "  -t  simulated run time, default 10 s\n"
+           "  -f  square wave on the flow sensor input, default 0 Hz\n"
+           "  -F  flash image file, loaded at boot and saved at the end\n"
+           "  -k  power cut during the op-th flash write or erase, saves the image, exit code 2\n"
+           "  -o  play patterns on this many output channels in all (LED included), up to %d\n"
+           "  -u  save the telemetry UART's bytes to a file, decode with telemdec\n"
+           "  -e  print every gpio edge with its virtual time\n"
+           "  -q  no firmware log output\n"
+           "  -p  print the perfStats table at the end\n"
+           "  -c  only check the task table, exit 1 if it has problems\n"
+           "stdin goes to the firmware console, e.g. 'p' prints perfStats\n", me, OUT_MAX_CH);
+}
+
+int main(int argc, char **argv){
+    double seconds = 10;
+    uint32_t flowHz = 0;
+    struct timespec t0, t1;
+    flowSnap_t snap;
+    outStats_t out;
+    double wallMs;
+    bool perf = false;
+    int opt, fl;
+
+    while((opt = getopt(argc, argv, "t:f:F:k:o:u:eqpch")) != -1){
+        switch(opt){
+        case 't': seconds = atof(optarg); break;
+        case 'f': flowHz = strtoul(optarg, NULL, 0); break;
+        case 'F': simFlashImage(optarg); break;
+        case 'k': simFlashCut(strtoul(optarg, NULL, 0)); break;
+        case 'o': benchCh = atoi(optarg); break;
+        case 'u': simUartFile(1, optarg); break;
+        case 'e': simGpioTrace(traceEdge); break;
+        case 'q': simLogOn = false; break;
+        case 'p': perf = true; break;
+        case 'c':
+            if(taskTableCheck(appTasks, appTaskCount, portNUM_PROCESSORS, CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ)){
+                return 1;
+            }
+            printf("task table ok: %d tasks, %d cores at %d MHz\n", appTaskCount, portNUM_PROCESSORS,
+                   CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ);
+            return 0;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    //the ESP console never blocks a reader, make stdin behave the same
+    fl = fcntl(0, F_GETFL);
+    if(fl != -1) fcntl(0, F_SETFL, fl | O_NONBLOCK);
+
+    simTaskCreate(mainTask, "main", 3584, NULL, 1, 0);
+    simGpioPulse(SIM_FLOW_PIN, flowHz);
+    if(benchCh > 1) simTaskCreate(benchTask, "bench", 2048, NULL, 1, 0);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    simRun((uint64_t)(seconds * 1000000));
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    if(fl != -1) fcntl(0, F_SETFL, fl);
+    wallMs = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+
+    printf("---- simulated %.3f s in %.1f ms wall (x%.0f)\n", simNow() / 1e6, wallMs,
+           wallMs > 0 ? simNow() / 1e3 / wallMs : 0);
+    simPrintSummary();
+    simGpioSummary();
+    simFlashSummary();
+    simUartSummary();
+    outGetStats(&out);
+    printf("outputs: %u channels, %.0f wakeups/s, %.0f edges/s, jitter avg %.1f max %u us\n",
+           out.channels, out.wakeups / (simNow() / 1e6), out.edges / (simNow() / 1e6),
+           out.edges ? (double)out.jitterSumUs / out.edges : 0.0, out.jitterMaxUs);
+    flowGet(&snap);
+    printf("flow: %u pulses, %u mHz, %u mL/min, %llu mL total, %llu mL lifetime\n", snap.pulses,
+           snap.rateMHz, snap.flowMlMin, (unsigned long long)snap.totalMl,
+           (unsigned long long)flowTotalMl());
+    simFlashSave();
+    if(perf){
+        perfDrain();
+        perfDump();
+    }
+    return 0;
+}
@@ -0,0 +1,221 @@
+//FreeRTOS task, tick, notify and queue calls on top of the simulator
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_freertos_hooks.h"
+#include "sim.h"
+
+//---------------------------- ticks -----------------------------
+TickType_t xTaskGetTickCount(void){
+    return (TickType_t)(simNow() / simTickUs());
+}
+
+TickType_t xTaskGetTickCountFromISR(void){
+    return xTaskGetTickCount();
+}
+
+//tick counts wrap like the real thing, deadlines are kept in 64-bit virtual time
+static uint64_t deadline(TickType_t ticks){
+    if(ticks == portMAX_DELAY) return SIM_NEVER;
+    return ((uint64_t)xTaskGetTickCount() + ticks) * simTickUs();
+}
+
+void vTaskDelay(TickType_t ticks){
+    if(ticks == 0){
+        simYield();
+        return;
+    }
+    simBlock(NULL, deadline(ticks));
+}
+
+void vTaskDelayUntil(TickType_t *prevWake, TickType_t increment){
+    int32_t ahead;
+
+    *prevWake += increment;
+    ahead = (int32_t)(*prevWake - xTaskGetTickCount());
+    if(ahead > 0) simBlock(NULL, deadline(ahead));      //else we're late, don't wait
+}
+
+//---------------------------- tasks -----------------------------
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                                   void *param, UBaseType_t prio, TaskHandle_t *handle, BaseType_t core){
+    simTask_t *t = simTaskCreate(fn, name, stackDepth, param, prio,
+                                 core == tskNO_AFFINITY ? -1 : core);
+    if(handle) *handle = t;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task){
+    simTaskDelete(task);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void){
+    return simTaskCurrent();
+}
+
+char *pcTaskGetTaskName(TaskHandle_t task){
+    return (char *)simTaskName(task ? task : simTaskCurrent());
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task){
+    return simTaskPrio(task ? task : simTaskCurrent());
+}
+
+//host stacks are nothing like xtensa ones, so there is no honest number to give
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task){
+    return 0;
+}
+
+BaseType_t xPortGetCoreID(void){
+    return simCoreId();
+}
+
+BaseType_t xPortInIsrContext(void){
+    return simInIsr();
+}
+
+//---------------------------- notifications -----------------------------
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks){
+    simTask_t *me = simTaskCurrent();
+    uint32_t *word = simTaskNotifyWord(me);
+    uint32_t val;
+
+    if(*word == 0 && ticks != 0) simBlock(word, deadline(ticks));
+    val = *word;
+    if(val) *word = clearOnExit ? 0 : val - 1;
+    return val;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task){
+    uint32_t *word = simTaskNotifyWord(task);
+    (*word)++;
+    simWakeAll(word);
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken){
+    xTaskNotifyGive(task);
+    if(woken) *woken = pdTRUE;
+}
+
+//---------------------------- queues -----------------------------
+struct simQueue {
+    uint8_t *buf;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+    UBaseType_t head;
+    UBaseType_t count;
+    char notEmpty;          //addresses to wait on
+    char notFull;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize){
+    QueueHandle_t q = calloc(1, sizeof(*q));
+    q->length = length;
+    q->itemSize = itemSize;
+    q->buf = calloc(length, itemSize ? itemSize : 1);
+    return q;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void){
+    QueueHandle_t q = xQueueCreate(1, 0);
+    q->count = 1;           //a mutex starts out given
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q){
+    free(q->buf);
+    free(q);
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t ticks){
+    uint64_t until = deadline(ticks);
+
+    while(q->count >= q->length){
+        if(ticks == 0 || simInIsr()) return errQUEUE_FULL;
+        if(!simBlock(&q->notFull, until) && q->count >= q->length) return errQUEUE_FULL;
+    }
+    if(q->itemSize) memcpy(q->buf + ((q->head + q->count) % q->length) * q->itemSize, item, q->itemSize);
+    q->count++;
+    simWakeAll(&q->notEmpty);
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken){
+    if(woken) *woken = pdFALSE;
+    return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t ticks){
+    uint64_t until = deadline(ticks);
+
+    while(q->count == 0){
+        if(ticks == 0 || simInIsr()) return pdFALSE;
+        if(!simBlock(&q->notEmpty, until) && q->count == 0) return pdFALSE;
+    }
+    if(q->itemSize) memcpy(item, q->buf + q->head * q->itemSize, q->itemSize);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    simWakeAll(&q->notFull);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceiveFromISR(QueueHandle_t q, void *item, BaseType_t *woken){
+    if(woken) *woken = pdFALSE;
+    return xQueueReceive(q, item, 0);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q){
+    return q->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q){
+    return q->length - q->count;
+}
+
+//---------------------------- tick hooks -----------------------------
+//Only simulated when somebody registers a hook, a tick every 1/CONFIG_FREERTOS_HZ
+//on each core would otherwise be wasted events.
+#define SIM_TICK_HOOKS 4
+
+typedef struct {
+    esp_freertos_tick_cb_t cb[SIM_TICK_HOOKS];
+    int n;
+    simEvent_t ev;
+    char name[12];
+} simTickCore_t;
+
+static simTickCore_t tickCores[portNUM_PROCESSORS];
+
+static void tickFired(void *arg){
+    simTickCore_t *tc = arg;
+    for(int i = 0; i < tc->n; i++) tc->cb[i]();
+    simEventArm(&tc->ev, simNow() + simTickUs());
+}
+
+esp_err_t esp_register_freertos_tick_hook_for_cpu(esp_freertos_tick_cb_t new_tick_cb, int cpuid){
+    simTickCore_t *tc;
+
+    if(cpuid < 0 || cpuid >= portNUM_PROCESSORS) return ESP_ERR_INVALID_ARG;
+    tc = &tickCores[cpuid];
+    if(tc->n >= SIM_TICK_HOOKS) return ESP_ERR_NO_MEM;
+    tc->cb[tc->n++] = new_tick_cb;
+    if(!tc->ev.armed){
+        snprintf(tc->name, sizeof(tc->name), "tick%d", cpuid);
+        tc->ev.name = tc->name;
+        tc->ev.fn = tickFired;
+        tc->ev.arg = tc;
+        tc->ev.core = cpuid;
+        simEventArm(&tc->ev, (simNow() / simTickUs() + 1) * simTickUs());
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_register_freertos_tick_hook(esp_freertos_tick_cb_t new_tick_cb){
+    return esp_register_freertos_tick_hook_for_cpu(new_tick_cb, xPortGetCoreID());
+}
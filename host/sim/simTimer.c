@@ -0,0 +1,165 @@
+//General purpose timers and esp_timer on the simulator's virtual clock
+
+#include <stddef.h>
+#include <stdio.h>
+#include "driver/timer.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "sim.h"
+
+#define APB_HZ 80000000ull
+
+typedef struct {
+    uint32_t divider;
+    bool running;
+    bool alarmEn;
+    bool intrEn;
+    uint64_t base;          //counter value at baseUs
+    uint64_t baseUs;
+    uint64_t alarm;
+    void (*isr)(void *);
+    void *arg;
+    simEvent_t ev;
+    char name[12];
+} simTimer_t;
+
+static simTimer_t timers[TIMER_GROUP_MAX][TIMER_MAX];
+
+static uint64_t count(simTimer_t *t){
+    if(!t->running) return t->base;
+    return t->base + (simNow() - t->baseUs) * APB_HZ / 1000000 / t->divider;
+}
+
+//freeze the counter so divider/start/pause changes don't rewrite history
+static void rebase(simTimer_t *t){
+    t->base = count(t);
+    t->baseUs = simNow();
+}
+
+//(re)schedule the alarm interrupt, if it can fire at all
+static void arm(simTimer_t *t){
+    uint64_t cnt = count(t), ticks;
+
+    if(!(t->running && t->alarmEn && t->intrEn && t->isr)){
+        simEventDisarm(&t->ev);
+        return;
+    }
+    ticks = t->alarm > cnt ? t->alarm - cnt : 0;
+    //round up, the alarm fires once the counter has reached the value
+    simEventArm(&t->ev, simNow() + (ticks * t->divider * 1000000 + APB_HZ - 1) / APB_HZ);
+}
+
+static void alarmFired(void *arg){
+    simTimer_t *t = arg;
+    t->alarmEn = false;     //hardware clears it, the ISR turns it back on
+    t->isr(t->arg);
+}
+
+esp_err_t timer_init(timer_group_t group, timer_idx_t idx, const timer_config_t *config){
+    simTimer_t *t = &timers[group][idx];
+    rebase(t);
+    t->divider = config->divider ? config->divider : 1;
+    t->running = config->counter_en == TIMER_START;
+    t->alarmEn = config->alarm_en == TIMER_ALARM_EN;
+    snprintf(t->name, sizeof(t->name), "timer%d.%d", group, idx);
+    t->ev.name = t->name;
+    t->ev.fn = alarmFired;
+    t->ev.arg = t;
+    arm(t);
+    return ESP_OK;
+}
+
+esp_err_t timer_start(timer_group_t group, timer_idx_t idx){
+    simTimer_t *t = &timers[group][idx];
+    rebase(t);
+    t->running = true;
+    arm(t);
+    return ESP_OK;
+}
+
+esp_err_t timer_pause(timer_group_t group, timer_idx_t idx){
+    simTimer_t *t = &timers[group][idx];
+    rebase(t);
+    t->running = false;
+    arm(t);
+    return ESP_OK;
+}
+
+esp_err_t timer_set_counter_value(timer_group_t group, timer_idx_t idx, uint64_t load_val){
+    simTimer_t *t = &timers[group][idx];
+    t->base = load_val;
+    t->baseUs = simNow();
+    arm(t);
+    return ESP_OK;
+}
+
+esp_err_t timer_get_counter_value(timer_group_t group, timer_idx_t idx, uint64_t *timer_val){
+    *timer_val = count(&timers[group][idx]);
+    return ESP_OK;
+}
+
+esp_err_t timer_set_alarm_value(timer_group_t group, timer_idx_t idx, uint64_t alarm_value){
+    simTimer_t *t = &timers[group][idx];
+    t->alarm = alarm_value;
+    arm(t);
+    return ESP_OK;
+}
+
+esp_err_t timer_set_alarm(timer_group_t group, timer_idx_t idx, timer_alarm_t alarm_en){
+    simTimer_t *t = &timers[group][idx];
+    t->alarmEn = alarm_en == TIMER_ALARM_EN;
+    arm(t);
+    return ESP_OK;
+}
+
+esp_err_t timer_enable_intr(timer_group_t group, timer_idx_t idx){
+    timers[group][idx].intrEn = true;
+    arm(&timers[group][idx]);
+    return ESP_OK;
+}
+
+esp_err_t timer_disable_intr(timer_group_t group, timer_idx_t idx){
+    timers[group][idx].intrEn = false;
+    arm(&timers[group][idx]);
+    return ESP_OK;
+}
+
+esp_err_t timer_isr_register(timer_group_t group, timer_idx_t idx, void (*fn)(void *), void *arg,
+                             int intr_alloc_flags, timer_isr_handle_t *handle){
+    simTimer_t *t = &timers[group][idx];
+    t->isr = fn;
+    t->arg = arg;
+    arm(t);
+    return ESP_OK;
+}
+
+//one host thread, nothing to lock
+void timer_spinlock_take(timer_group_t group){
+}
+
+void timer_spinlock_give(timer_group_t group){
+}
+
+void timer_group_clr_intr_status_in_isr(timer_group_t group, timer_idx_t idx){
+}
+
+void timer_group_enable_alarm_in_isr(timer_group_t group, timer_idx_t idx){
+    timer_set_alarm(group, idx, TIMER_ALARM_EN);
+}
+
+uint64_t timer_group_get_counter_value_in_isr(timer_group_t group, timer_idx_t idx){
+    return count(&timers[group][idx]);
+}
+
+void timer_group_set_alarm_value_in_isr(timer_group_t group, timer_idx_t idx, uint64_t alarm_val){
+    timer_set_alarm_value(group, idx, alarm_val);
+}
+
+//---------------------------- esp_timer, log -----------------------------
+int64_t esp_timer_get_time(void){
+    return simNow();
+}
+
+uint32_t esp_log_timestamp(void){
+    return simNow() / 1000;
+}
@@ -0,0 +1,91 @@
+//UARTs on the simulator: transmit only. The driver's transmit buffer empties at
+//the baud rate (10 bits per byte), a writer that finds it full blocks until
+//there is room, like uart_write_bytes() on the ESP32. What is sent can go to a file.
+
+#include <stdio.h>
+#include "driver/uart.h"
+#include "sim.h"
+
+typedef struct {
+    bool installed;
+    int baud;
+    uint32_t txBuf;
+    uint64_t drainedAt;     //virtual time the buffer will be empty
+    uint64_t bytes;
+    uint64_t blockedUs;
+    FILE *out;
+} simUart_t;
+
+static simUart_t uarts[UART_NUM_MAX];
+static const char *outPath[UART_NUM_MAX];
+
+void simUartFile(int port, const char *path){
+    if(port >= 0 && port < UART_NUM_MAX) outPath[port] = path;
+}
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config){
+    if(uart_num >= UART_NUM_MAX || uart_config->baud_rate <= 0) return ESP_ERR_INVALID_ARG;
+    uarts[uart_num].baud = uart_config->baud_rate;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num){
+    return uart_num < UART_NUM_MAX ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, QueueHandle_t *uart_queue, int intr_alloc_flags){
+    simUart_t *u = &uarts[uart_num];
+
+    if(uart_num >= UART_NUM_MAX || u->installed || rx_buffer_size <= 128) return ESP_ERR_INVALID_ARG;
+    u->installed = true;
+    u->txBuf = tx_buffer_size > 0 ? tx_buffer_size : 128;     //0 = only the hardware fifo
+    if(!u->baud) u->baud = 115200;
+    if(outPath[uart_num] && (u->out = fopen(outPath[uart_num], "wb")) == NULL){
+        printf("can't write %s\n", outPath[uart_num]);
+    }
+    return ESP_OK;
+}
+
+static uint64_t byteUs(simUart_t *u, uint64_t n){
+    return (n * 10 * 1000000 + u->baud - 1) / u->baud;
+}
+
+int uart_write_bytes(uart_port_t uart_num, const char *src, size_t size){
+    simUart_t *u = &uarts[uart_num];
+    size_t done = 0;
+
+    if(uart_num >= UART_NUM_MAX || !u->installed) return -1;
+    while(done < size){
+        uint64_t now = simNow();
+        uint64_t level, room, n;
+        if(u->drainedAt < now) u->drainedAt = now;
+        level = (u->drainedAt - now) * u->baud / 10 / 1000000;      //bytes still queued
+        room = level < u->txBuf ? u->txBuf - level : 0;
+        if(room == 0){
+            uint64_t wake = u->drainedAt - byteUs(u, u->txBuf / 2);  //until half of it went out
+            if(wake <= now) wake = now + 1;
+            u->blockedUs += wake - now;
+            simBlock(NULL, wake);
+            continue;
+        }
+        n = size - done < room ? size - done : room;
+        if(u->out) fwrite(src + done, 1, n, u->out);
+        u->drainedAt += byteUs(u, n);
+        u->bytes += n;
+        done += n;
+    }
+    return done;
+}
+
+void simUartSummary(void){
+    for(int i = 0; i < UART_NUM_MAX; i++){
+        simUart_t *u = &uarts[i];
+        if(!u->installed) continue;
+        if(u->out) fflush(u->out);
+        printf("uart%d: %llu bytes at %d baud, %.1f%% busy, writers blocked %llu ms\n", i,
+               (unsigned long long)u->bytes, u->baud,
+               simNow() ? 100.0 * byteUs(u, u->bytes) / simNow() : 0.0,
+               (unsigned long long)(u->blockedUs / 1000));
+    }
+}
@@ -0,0 +1,82 @@
+//What a log line costs the code that logs it: DLOGI() against ESP_LOGI(), in
+//time per call and in stack. The host's ESP_LOGI is a printf, here into
+///dev/null. The drain's time per record is shown too, that's where the
+//formatting went. Stack is measured by running each call on a thread whose
+//stack was filled with a pattern, less what an empty call leaves.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+#include "dlog.h"
+#include "fakeRtos.h"
+
+#define CALLS      200000
+#define BATCH      50              //calls between drains, less than a ring
+#define STACK_SIZE (64 * 1024)
+
+static const char tag[] = "bench";
+static volatile int arg = 42;
+
+static double nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void callNone(void){}
+static void callDlog(void){ DLOGI(tag, "flow started, %u mL/min at %d", arg, arg + 1); }
+static void callEsp(void){ ESP_LOGI(tag, "flow started, %u mL/min at %d", arg, arg + 1); }
+
+static void *runOnce(void *fn){
+    ((void (*)(void))fn)();
+    return NULL;
+}
+
+//bytes of stack the call touched, thread start included
+static size_t stackUsed(void (*fn)(void)){
+    pthread_attr_t attr;
+    pthread_t th;
+    uint8_t *stack;
+    size_t i;
+
+    if(posix_memalign((void **)&stack, 4096, STACK_SIZE)) return 0;
+    memset(stack, 0xa5, STACK_SIZE);
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, STACK_SIZE);
+    pthread_create(&th, &attr, runOnce, (void *)fn);
+    pthread_join(th, NULL);
+    for(i = 0; i < STACK_SIZE && stack[i] == 0xa5; i++);
+    free(stack);
+    return STACK_SIZE - i;
+}
+
+int main(void){
+    double putNs = 0, drainNs = 0, espNs, t0;
+    size_t base;
+
+    dlogSetRate(tag, 60000, 60000);
+    if(!freopen("/dev/null", "w", stdout)) return 1;
+
+    for(int i = 0; i < CALLS / BATCH; i++){
+        fakeMs += 1000;
+        t0 = nowNs();
+        for(int k = 0; k < BATCH; k++) callDlog();
+        putNs += nowNs() - t0;
+        t0 = nowNs();
+        dlogDrain();
+        drainNs += nowNs() - t0;
+    }
+    t0 = nowNs();
+    for(int i = 0; i < CALLS; i++) callEsp();
+    espNs = nowNs() - t0;
+
+    base = stackUsed(callNone);
+    fprintf(stderr, "DLOGI    %6.1f ns per call, %4zu bytes of stack (drain %.1f ns per record)\n",
+            putNs / CALLS, stackUsed(callDlog) - base, drainNs / CALLS);
+    fprintf(stderr, "ESP_LOGI %6.1f ns per call, %4zu bytes of stack\n",
+            espNs / CALLS, stackUsed(callEsp) - base);
+    return 0;
+}
@@ -0,0 +1,130 @@
+//Cost of posting a blink request: sigRingPostCount() against a queue with a
+//100 ms send timeout, the way LEDblink() used xQueueSend() before. On the PC
+//the queue is a mutex and a condition variable around a ring, which is what
+//a FreeRTOS queue does with its critical section and event lists.
+//Producers post while one consumer drains, each post is timed. The max is
+//mostly a producer being preempted, the average is the cost that matters.
+//
+//  benchSigRing [producers]
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include "sigRing.h"
+
+#define POSTS   200000              //per producer
+#define SLOTS   8                   //blinkRing's size
+#define MAX_PRODUCERS 16
+
+SIGRING_DEFINE(ring, SLOTS);
+
+//the queue being replaced: blocking send with a timeout
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t notFull, notEmpty;
+    uint32_t buf[SLOTS];
+    uint32_t head, tail;
+} q = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+static bool queueSend(uint32_t val, int timeoutMs){
+    struct timespec until;
+    bool ok = true;
+
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_nsec += timeoutMs * 1000000L;
+    until.tv_sec += until.tv_nsec / 1000000000L;
+    until.tv_nsec %= 1000000000L;
+    pthread_mutex_lock(&q.lock);
+    while(ok && q.head - q.tail == SLOTS) ok = pthread_cond_timedwait(&q.notFull, &q.lock, &until) == 0;
+    if(ok){
+        q.buf[q.head++ % SLOTS] = val;
+        pthread_cond_signal(&q.notEmpty);
+    }
+    pthread_mutex_unlock(&q.lock);
+    return ok;
+}
+
+static bool queueTake(uint32_t *val){
+    bool ok;
+
+    pthread_mutex_lock(&q.lock);
+    ok = q.head != q.tail;
+    if(ok){
+        *val = q.buf[q.tail++ % SLOTS];
+        pthread_cond_signal(&q.notFull);
+    }
+    pthread_mutex_unlock(&q.lock);
+    return ok;
+}
+
+typedef struct {
+    bool useQueue;
+    double sumNs, maxNs;
+} producer_t;
+
+static uint32_t running;
+
+static double nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void *producer(void *arg){
+    producer_t *p = arg;
+
+    for(int i = 0; i < POSTS; i++){
+        double t0 = nowNs(), ns;
+        if(p->useQueue) queueSend(1, 100);
+        else sigRingPostCount(&ring, 1);
+        ns = nowNs() - t0;
+        p->sumNs += ns;
+        if(ns > p->maxNs) p->maxNs = ns;
+    }
+    __atomic_fetch_sub(&running, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void run(const char *name, bool useQueue, int producers){
+    pthread_t th[MAX_PRODUCERS];
+    producer_t prod[MAX_PRODUCERS] = { 0 };
+    uint64_t taken = 0;
+    uint32_t val;
+    double sum = 0, max = 0;
+    bool more = true;
+
+    sigRingInit(&ring, ringSlots, SLOTS);
+    running = producers;
+    for(int i = 0; i < producers; i++){
+        prod[i].useQueue = useQueue;
+        pthread_create(&th[i], NULL, producer, &prod[i]);
+    }
+    while(more){
+        more = __atomic_load_n(&running, __ATOMIC_ACQUIRE) != 0;
+        while(useQueue ? queueTake(&val) : sigRingTake(&ring, &val)){
+            taken += val;
+            more = true;
+        }
+        sched_yield();
+    }
+    for(int i = 0; i < producers; i++){
+        pthread_join(th[i], NULL);
+        sum += prod[i].sumNs;
+        if(prod[i].maxNs > max) max = prod[i].maxNs;
+    }
+    printf("%-20s %2d producers: post avg %7.1f ns, max %9.0f ns, %llu of %d counts arrived\n",
+           name, producers, sum / producers / POSTS, max, (unsigned long long)taken, producers * POSTS);
+}
+
+int main(int argc, char **argv){
+    int producers = argc > 1 ? atoi(argv[1]) : 4;
+
+    if(producers < 1 || producers > MAX_PRODUCERS) producers = 4;
+    run("sigRingPostCount", false, 1);
+    run("queue send, 100 ms", true, 1);
+    run("sigRingPostCount", false, producers);
+    run("queue send, 100 ms", true, producers);
+    return 0;
+}
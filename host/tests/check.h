@@ -0,0 +1,32 @@
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+//Minimal assertions for the host tests: a failed CHECK prints where and keeps
+//going, checkDone() turns the count into the exit code ctest looks at.
+
+#include <stdio.h>
+
+static int checkFails;
+
+#define CHECK(cond) do{ \
+        if(!(cond)){ \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            checkFails++; \
+        } \
+    }while(0)
+
+//like CHECK, for two integers, prints both values
+#define CHECK_EQ(a, b) do{ \
+        long long _a = (long long)(a), _b = (long long)(b); \
+        if(_a != _b){ \
+            printf("%s:%d: %s == %s failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); \
+            checkFails++; \
+        } \
+    }while(0)
+
+static inline int checkDone(const char *name){
+    printf("%s: %s, %d failed checks\n", name, checkFails ? "FAILED" : "ok", checkFails);
+    return checkFails ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,46 @@
+//Just enough of the simulator for tests that link one module of main/ on its
+//own: the test picks the core and the clock, the task side is never started.
+
+#include <signal.h>
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "perfStats.h"
+#include "fakeRtos.h"
+
+int fakeCore;
+uint32_t fakeMs;
+uint32_t fakeMsStep;
+volatile int fakeInIrq;
+bool simLogOn = true;
+static int fakeIrqDepth;
+static sigset_t fakeIrqWas;
+
+BaseType_t xPortGetCoreID(void){ return fakeCore; }
+BaseType_t xPortInIsrContext(void){ return fakeInIrq; }
+uint32_t esp_log_timestamp(void){ return __atomic_fetch_add(&fakeMs, fakeMsStep, __ATOMIC_RELAXED); }
+
+//critical sections nest, the signal is masked from the first enter to the last
+//exit. The last exit puts back what was before, so in the handler it stays masked.
+void fakeIrqOff(void){
+    sigset_t s;
+
+    if(fakeIrqDepth++) return;
+    sigemptyset(&s);
+    sigaddset(&s, FAKE_IRQ_SIG);
+    sigprocmask(SIG_BLOCK, &s, &fakeIrqWas);
+}
+
+void fakeIrqOn(void){
+    if(--fakeIrqDepth) return;
+    sigprocmask(SIG_SETMASK, &fakeIrqWas, NULL);
+}
+
+TickType_t xTaskGetTickCount(void){ return fakeMs / portTICK_PERIOD_MS; }
+void vTaskDelayUntil(TickType_t *prev, TickType_t inc){ abort(); }
+uint8_t perfAddTask(const char *name, TaskHandle_t task, bool tickWoken){ return PERF_NO_ID; }
+void perfEvent(uint8_t type, uint8_t id){}
+void perfRunTick(uint8_t id, TickType_t due){}
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth,
+                                   void *param, UBaseType_t prio, TaskHandle_t *handle, BaseType_t core){ abort(); }
+uint8_t perfAddIsr(const char *name){ return PERF_NO_ID; }
@@ -0,0 +1,18 @@
+#ifndef _FAKERTOS_H_
+#define _FAKERTOS_H_
+
+#include <stdint.h>
+#include <signal.h>
+
+#define FAKE_IRQ_SIG SIGALRM        //the fake interrupt, see FAKE_IRQ in freertos/FreeRTOS.h
+
+extern int fakeCore;                //what xPortGetCoreID() returns
+extern uint32_t fakeMs;             //what esp_log_timestamp() returns
+extern uint32_t fakeMsStep;         //added to fakeMs by every esp_log_timestamp()
+extern volatile int fakeInIrq;      //what xPortInIsrContext() returns, set by the handler
+
+//mask and unmask FAKE_IRQ_SIG, what critical sections do in a FAKE_IRQ build
+void fakeIrqOff(void);
+void fakeIrqOn(void);
+
+#endif
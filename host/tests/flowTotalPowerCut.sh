@@ -0,0 +1,53 @@
+#!/bin/sh
+# Power-cut torture of the flow total log: run the simulator again and again on
+# the same flash image, each time pulling the plug during a different flash
+# write or erase, then boot on what was left. Every boot must find the log,
+# the total must never go back, and opening must stay a handful of reads.
+# Enough runs to go round the 16 sector log more than once.
+#
+#   flowTotalPowerCut.sh path/to/g02sim [runs]
+
+sim=${1:?usage: $0 g02sim [runs]}
+runs=${2:-80}
+img=flowTotalPowerCut.img
+maxReads=40                     # binary searches over 16 sectors and ~250 slots
+
+rm -f $img
+prev=0
+worstReads=0
+i=0
+while [ $i -lt $runs ]; do
+    cut=$((20 + (i * 37) % 160))
+    "$sim" -t 200 -f 500 -q -F $img -k $cut > /dev/null
+    rc=$?
+    if [ $rc -ne 0 ] && [ $rc -ne 2 ]; then
+        echo "run $i: simulator failed with $rc"
+        exit 1
+    fi
+
+    line=$("$sim" -t 0 -F $img | grep "flowTotal: ")
+    set -- $(echo "$line" | sed -n 's/.*flowTotal: \([0-9]*\) mL from record \([0-9]*\), .* \([0-9]*\) reads .*/\1 \2 \3/p')
+    if [ $# -ne 3 ]; then
+        echo "run $i (cut at op $cut): boot didn't recover the log: $line"
+        exit 1
+    fi
+    total=$1 record=$2 reads=$3
+    if [ "$total" -lt "$prev" ]; then
+        echo "run $i (cut at op $cut): total went back from $prev to $total mL"
+        exit 1
+    fi
+    if [ "$reads" -gt $maxReads ]; then
+        echo "run $i: opening the log took $reads reads"
+        exit 1
+    fi
+    [ "$reads" -gt $worstReads ] && worstReads=$reads
+    prev=$total
+    i=$((i + 1))
+done
+
+echo "$runs power cuts: $total mL, last record $record, boot reads at most $worstReads"
+if [ "$record" -lt 4096 ]; then
+    echo "the log didn't go round, add runs"
+    exit 1
+fi
+rm -f $img
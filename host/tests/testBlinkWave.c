@@ -0,0 +1,120 @@
+//blinkWave: compile requests and play them, the edge times must come out exact
+
+#include <string.h>
+#include "blinkWave.h"
+#include "check.h"
+
+#define MAX_EDGES 256
+
+typedef struct {
+    uint64_t at[MAX_EDGES];         //absolute time the level starts, us
+    uint8_t level[MAX_EDGES];
+    int n;
+    uint64_t endUs;
+} edges_t;
+
+//play the wave from time 0 the way the timer ISR does
+static void play(const blinkWave_t *wave, edges_t *e){
+    blinkSeq_t seq;
+    blinkSeg_t seg;
+    uint64_t at = 0;
+
+    memset(e, 0, sizeof(*e));
+    blinkSeqStart(&seq, wave);
+    while(blinkSeqNext(&seq, &seg) && e->n < MAX_EDGES){
+        e->at[e->n] = at;
+        e->level[e->n++] = seg.level;
+        at += seg.durUs;
+    }
+    e->endUs = at;
+}
+
+static void testCountOnOffGapRepeat(void){
+    blinkWave_t w;
+    edges_t e;
+    static const uint64_t at[] = { 0, 1000, 3000, 4000, 11000, 12000, 14000, 15000 };
+
+    CHECK(blinkCompile(&(blinkReq_t){ .count = 2, .onUs = 1000, .offUs = 2000, .gapUs = 5000, .repeat = 2 }, &w));
+    CHECK_EQ(w.nSeg, 4);                    //on off on off+gap
+    CHECK_EQ(w.seg[3].durUs, 7000);
+    CHECK_EQ(blinkWaveUs(&w), 22000);
+
+    play(&w, &e);
+    CHECK_EQ(e.n, 8);
+    for(int i = 0; i < 8; i++){
+        CHECK_EQ(e.at[i], at[i]);
+        CHECK_EQ(e.level[i], i % 2 == 0);
+    }
+    CHECK_EQ(e.endUs, 22000);
+}
+
+static void testZeroLengthMerged(void){
+    blinkWave_t w;
+    edges_t e;
+
+    //no off time: the blinks run together into one long on, then the gap
+    CHECK(blinkCompile(&(blinkReq_t){ .count = 3, .onUs = 500, .offUs = 0, .gapUs = 800, .repeat = 1 }, &w));
+    CHECK_EQ(w.nSeg, 2);
+    CHECK_EQ(w.seg[0].level, 1);
+    CHECK_EQ(w.seg[0].durUs, 1500);
+    CHECK_EQ(w.seg[1].level, 0);
+    CHECK_EQ(w.seg[1].durUs, 800);
+
+    //no on time: all dark, one segment however many blinks
+    CHECK(blinkCompile(&(blinkReq_t){ .count = 4, .onUs = 0, .offUs = 250, .gapUs = 0, .repeat = 3 }, &w));
+    CHECK_EQ(w.nSeg, 1);
+    CHECK_EQ(w.seg[0].durUs, 1000);
+    play(&w, &e);
+    CHECK_EQ(e.n, 3);
+    CHECK_EQ(e.at[2], 2000);
+    CHECK_EQ(e.endUs, 3000);
+
+    //no gap: nothing is added after the last off
+    CHECK(blinkCompile(&(blinkReq_t){ .count = 1, .onUs = 500000, .offUs = 500000, .gapUs = 0, .repeat = 5 }, &w));
+    CHECK_EQ(w.nSeg, 2);
+    play(&w, &e);
+    CHECK_EQ(e.n, 10);
+    CHECK_EQ(e.at[9], 4500000);
+    CHECK_EQ(e.endUs, 5000000);
+}
+
+static void testRejected(void){
+    blinkWave_t w;
+
+    CHECK(blinkCompile(&(blinkReq_t){ .count = BLINK_MAX_COUNT, .onUs = 100, .offUs = 100, .repeat = 1 }, &w));
+    CHECK_EQ(w.nSeg, BLINK_MAX_SEGS);
+    CHECK(!blinkCompile(&(blinkReq_t){ .count = BLINK_MAX_COUNT + 1, .onUs = 100, .offUs = 100, .repeat = 1 }, &w));
+    CHECK(!blinkCompile(&(blinkReq_t){ .count = 0, .onUs = 100, .offUs = 100, .repeat = 1 }, &w));
+    CHECK(!blinkCompile(&(blinkReq_t){ .count = -1, .onUs = 100, .offUs = 100, .repeat = 1 }, &w));
+    CHECK(!blinkCompile(&(blinkReq_t){ .count = 1, .onUs = 100, .offUs = 100, .repeat = 0 }, &w));
+    CHECK(!blinkCompile(&(blinkReq_t){ .count = 2, .onUs = 0, .offUs = 0, .gapUs = 0, .repeat = 1 }, &w));
+
+    //a rejected request leaves an empty wave, playing it gives nothing
+    blinkSeq_t seq;
+    blinkSeg_t seg;
+    blinkSeqStart(&seq, &w);
+    CHECK(!blinkSeqNext(&seq, &seg));
+}
+
+//segments the timer can't keep up with are refused, after merging
+static void testMinSegment(void){
+    blinkWave_t w;
+
+    CHECK(!blinkCompile(&(blinkReq_t){ .count = 1, .onUs = 1, .offUs = 1, .repeat = 1000000000 }, &w));
+    CHECK(!blinkCompile(&(blinkReq_t){ .count = 1, .onUs = BLINK_MIN_SEG_US - 1, .offUs = 1000, .repeat = 1 }, &w));
+    CHECK(blinkCompile(&(blinkReq_t){ .count = 1, .onUs = BLINK_MIN_SEG_US, .offUs = BLINK_MIN_SEG_US, .repeat = 1 }, &w));
+    //short off times that merge with the gap into one long enough segment are fine
+    CHECK(blinkCompile(&(blinkReq_t){ .count = 1, .onUs = 1000, .offUs = 1, .gapUs = 200, .repeat = 1 }, &w));
+    CHECK_EQ(w.seg[1].durUs, 201);
+    //and short on times that merge because off is zero
+    CHECK(blinkCompile(&(blinkReq_t){ .count = 4, .onUs = 30, .offUs = 0, .gapUs = 100, .repeat = 1 }, &w));
+    CHECK_EQ(w.seg[0].durUs, 120);
+}
+
+int main(void){
+    testCountOnOffGapRepeat();
+    testZeroLengthMerged();
+    testRejected();
+    testMinSegment();
+    return checkDone("blinkWave");
+}
@@ -0,0 +1,212 @@
+//dlog: records put from two cores come out in the order they were put, each
+//line exactly what printf would have made of it, and every loss is reported.
+//Built with FAKE_IRQ: a timer signal plays an ISR that logs in the middle of dlogPut().
+
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#define LOG_LOCAL_LEVEL ESP_LOG_VERBOSE
+#include "esp_log.h"
+#include "dlog.h"
+#include "fakeRtos.h"
+#include "check.h"
+
+static const char tagA[] = "alpha";
+static const char tagB[] = "beta";
+static const char tagRl[] = "rl";
+static const char tagFull[] = "full";
+static const char tagTask[] = "task";
+static const char tagIsr[] = "isr";
+
+static char out[16384];
+static char want[16384];
+static size_t wantLen;
+
+//drain with stdout going to a temporary file, return what was written
+static const char *drain(void){
+    FILE *f = tmpfile();
+    int saved;
+    size_t n;
+
+    fflush(stdout);
+    saved = dup(1);
+    dup2(fileno(f), 1);
+    dlogDrain();
+    fflush(stdout);
+    dup2(saved, 1);
+    close(saved);
+    rewind(f);
+    n = fread(out, 1, sizeof(out) - 1, f);
+    out[n] = 0;
+    fclose(f);
+    return out;
+}
+
+#define EXPECT(letter, tag, fmt, ...) \
+    (wantLen += snprintf(want + wantLen, sizeof(want) - wantLen, letter " (%u) %s: " fmt "\n", \
+                         fakeMs, tag, ##__VA_ARGS__))
+
+static int countLines(const char *s, const char *what){
+    int n = 0;
+    while((s = strstr(s, what)) != NULL){
+        n++;
+        s++;
+    }
+    return n;
+}
+
+static void testOrderAndFormat(void){
+    static const char *words[] = { "", "x", "a longer string" };
+    static int local;
+
+    wantLen = 0;
+    for(int i = 0; i < 40; i++){
+        fakeCore = (i * 7 / 3) % 2;                     //irregular mix of both cores
+        fakeMs += 100;                                  //inside the rate limit
+        switch(i % 4){
+        case 0:
+            DLOGI(tagA, "n=%d neg=%d", i, -i);
+            EXPECT("I", tagA, "n=%d neg=%d", i, -i);
+            break;
+        case 1:
+            DLOGW(tagB, "u=%u x=%08x c=%c", 4000000000u - i, 0xdead0000u + i, 'a' + i);
+            EXPECT("W", tagB, "u=%u x=%08x c=%c", 4000000000u - i, 0xdead0000u + i, 'a' + i);
+            break;
+        case 2:
+            DLOGE(tagA, "s='%s' p=%p", words[i % 3], (void *)&local);
+            EXPECT("E", tagA, "s='%s' p=%p", words[i % 3], (void *)&local);
+            break;
+        default:
+            DLOGD(tagB, "no args");
+            EXPECT("D", tagB, "no args");
+            break;
+        }
+    }
+    drain();
+    CHECK(strcmp(out, want) == 0);
+    if(strcmp(out, want)) printf("got:\n%s\nwant:\n%s", out, want);
+    CHECK(strcmp(drain(), "") == 0);
+}
+
+static void testRateLimit(void){
+    char line[64];
+
+    //a burst of 15 at once: 10 go out, 5 are reported dropped
+    fakeCore = 0;
+    fakeMs += 10000;
+    for(int i = 0; i < 15; i++) DLOGI(tagRl, "burst %d", i);
+    drain();
+    CHECK_EQ(countLines(out, "rl: burst"), 10);
+    snprintf(line, sizeof(line), "W (%u) dlog: 5 lines dropped\n", fakeMs);
+    CHECK(strstr(out, line) != NULL);
+
+    //after 2.5 days of quiet the elapsed ms times the rate overflow 32 bits:
+    //214748365 ms * 20/s is 4 mod 2^32, that must not mean "no new tokens"
+    fakeMs += 214748365;
+    for(int i = 0; i < 3; i++) DLOGI(tagRl, "after %d", i);
+    drain();
+    CHECK_EQ(countLines(out, "rl: after"), 3);
+    CHECK(strstr(out, "dropped") == NULL);
+
+    //a slow trickle refills one token at a time
+    for(int i = 0; i < 10; i++) DLOGI(tagRl, "empty %d", i);
+    drain();
+    CHECK_EQ(countLines(out, "rl: empty"), 7);
+    fakeMs += 50;
+    DLOGI(tagRl, "one more");
+    DLOGI(tagRl, "one too many");
+    drain();
+    CHECK(strstr(out, "rl: one more") != NULL);
+    CHECK(strstr(out, "rl: one too many") == NULL);
+}
+
+//more than a ring holds between drains: the rest is counted, not half written
+static void testRingFull(void){
+    char line[64];
+
+    dlogSetRate(tagFull, 1000, 200);
+    fakeCore = 1;
+    fakeMs += 1000;
+    for(int i = 0; i < DLOG_RING_LEN + 10; i++) DLOGI(tagFull, "rec %d", i);
+    drain();
+    CHECK_EQ(countLines(out, "full: rec"), DLOG_RING_LEN);
+    CHECK(strstr(out, "full: rec 0\n") != NULL);
+    snprintf(line, sizeof(line), "full: rec %d\n", DLOG_RING_LEN - 1);
+    CHECK(strstr(out, line) != NULL);
+    snprintf(line, sizeof(line), "dlog: %d lines dropped\n", 10);
+    CHECK(strstr(out, line) != NULL);
+}
+
+static volatile int isrLines;
+static uint32_t lastMs;
+static int lines, backwards, dropped;
+
+//drain, count the lines and the times one wasn't later than the one before
+static void drainInOrder(void){
+    uint32_t ms;
+    int n;
+
+    drain();
+    for(const char *l = out; *l; l = strchr(l, '\n') + 1){
+        if(sscanf(l, "W (%*u) dlog: %d lines dropped", &n) == 1){
+            dropped += n;               //a drain that came late, fine if counted
+            continue;
+        }
+        if(sscanf(l, "%*c (%u)", &ms) != 1) continue;
+        backwards += lines && (int32_t)(ms - lastMs) <= 0;
+        lastMs = ms;
+        lines++;
+    }
+}
+
+//logs on the interrupted core, and on the other one as if it ran at that moment
+static void fakeIsr(int sig){
+    int core = fakeCore;
+
+    fakeInIrq = 1;
+    DLOGI(tagIsr, "isr %d", isrLines++);
+    fakeInIrq = 0;
+    fakeCore = !core;
+    DLOGI(tagIsr, "other core %d", isrLines++);
+    fakeCore = core;
+}
+
+//an ISR that logs while the code it interrupted is inside dlogPut() must not
+//come out of order, nor make the other core's lines come out of order. Every
+//esp_log_timestamp() is one ms later here, so the lines must come out with
+//their times strictly rising.
+static void testIsrOrder(void){
+    struct sigaction sa = { .sa_handler = fakeIsr };
+    struct itimerval every = { { 0, 20 }, { 0, 20 } }, off = { { 0, 0 }, { 0, 0 } };
+    int puts = 0;
+
+    dlogSetRate(tagTask, 60000, 60000);
+    dlogSetRate(tagIsr, 60000, 60000);
+    fakeMsStep = 1;
+    sigaction(FAKE_IRQ_SIG, &sa, NULL);
+    setitimer(ITIMER_REAL, &every, NULL);
+    while(isrLines < 10000 && puts < 20000000){
+        for(int i = 0; i < 20; i++, puts++){
+            fakeCore = (i * 7 / 3) % 2;
+            DLOGI(tagTask, "task %d", puts);
+        }
+        drainInOrder();
+    }
+    setitimer(ITIMER_REAL, &off, NULL);
+    drainInOrder();
+    fakeMsStep = 0;
+    printf("%d lines, %d from the fake ISR\n", lines, isrLines);
+    CHECK(isrLines > 0);
+    CHECK_EQ(lines + dropped, puts + isrLines);
+    CHECK_EQ(backwards, 0);
+}
+
+int main(void){
+    testOrderAndFormat();
+    testRateLimit();
+    testRingFull();
+    testIsrOrder();
+    return checkDone("dlog");
+}
@@ -0,0 +1,190 @@
+//flowCalc: replay pulse traces sampled every 100 ms, the way flowTask does,
+//and hold the rate and volume to error bounds. Traces: steady with jitter up
+//to 10 kHz, a stop, a ramp, and days at 10 kHz so the 32-bit count wraps.
+//The cost per sample is measured by benchFlowCalc.c.
+
+#include <math.h>
+#include <string.h>
+#include "flowCalc.h"
+#include "check.h"
+
+#define SAMPLE_US 100000
+#define K_MILLI   450000
+
+static const flowCfg_t cfg = { .kMilli = K_MILLI, .timeoutUs = 2000000, .window = 10 };
+
+//pulse source: edges at a rate given by a function of time, each period off
+//by up to +-jitter of itself
+typedef struct {
+    double (*hz)(double s);
+    double jitter;
+    uint32_t rnd;
+    double nextUs;          //time of the next edge
+    uint32_t pulses;
+    uint64_t edgeUs;        //time of the last edge
+} source_t;
+
+static double uniform(source_t *src){
+    src->rnd = src->rnd * 1103515245 + 12345;
+    return (src->rnd >> 8) / (double)(1 << 24) * 2 - 1;
+}
+
+static void sourceStart(source_t *src, double (*hz)(double), double jitter, uint32_t pulses){
+    memset(src, 0, sizeof(*src));
+    src->hz = hz;
+    src->jitter = jitter;
+    src->rnd = 1;
+    src->pulses = pulses;
+    src->nextUs = -1;
+}
+
+//run the source up to "nowUs"
+static void sourceRun(source_t *src, uint64_t nowUs){
+    while(1){
+        if(src->nextUs < 0){        //idle, look for flow again every ms
+            double hz = src->hz(nowUs / 1e6);
+            if(hz <= 0) return;
+            src->nextUs = nowUs + 1e6 / hz;
+        }
+        if(src->nextUs > nowUs) return;
+        src->edgeUs = (uint64_t)src->nextUs;
+        src->pulses++;
+        double hz = src->hz(src->nextUs / 1e6);
+        src->nextUs = hz > 0 ? src->nextUs + 1e6 / hz * (1 + src->jitter * uniform(src)) : -1;
+    }
+}
+
+static uint64_t wantMl(uint64_t pulses){
+    return pulses * 1000000 / K_MILLI;
+}
+
+static double hzSteady;
+static double steady(double s){ return hzSteady; }
+static double stopAt5(double s){ return s < 5 ? 1000 : 0; }
+static double ramp(double s){ return s < 20 ? 500 * s : 10000; }
+
+//steady flow with 20% period jitter: once the window is full the rate must be
+//within "maxErr" of the true one, and the volume exact
+static void testSteady(double hz, double maxErr){
+    flowCalc_t fc;
+    flowSnap_t snap;
+    source_t src;
+    double worst = 0;
+
+    hzSteady = hz;
+    flowCalcInit(&fc, &cfg);
+    sourceStart(&src, steady, 0.2, 0);
+    for(uint64_t t = SAMPLE_US; t <= 30000000; t += SAMPLE_US){
+        sourceRun(&src, t);
+        flowCalcAdd(&fc, src.pulses, src.edgeUs, t, &snap);
+        CHECK_EQ(snap.totalMl, wantMl(src.pulses));
+        if(t < 1500000) continue;
+        double err = fabs(snap.rateMHz / 1000.0 - hz) / hz;
+        if(err > worst) worst = err;
+        CHECK_EQ(snap.flowMlMin, (uint64_t)snap.rateMHz * 60000 / K_MILLI);
+    }
+    printf("steady %5.0f Hz, 20%% jitter: worst rate error %.3f%%\n", hz, worst * 100);
+    CHECK(worst <= maxErr);
+}
+
+//when the flow stops the rate falls every sample, and is 0 within the timeout
+static void testStop(void){
+    flowCalc_t fc;
+    flowSnap_t snap;
+    source_t src;
+    uint32_t prev = 0;
+    uint64_t zeroAt = 0;
+
+    flowCalcInit(&fc, &cfg);
+    sourceStart(&src, stopAt5, 0.1, 0);
+    for(uint64_t t = SAMPLE_US; t <= 10000000; t += SAMPLE_US){
+        sourceRun(&src, t);
+        flowCalcAdd(&fc, src.pulses, src.edgeUs, t, &snap);
+        if(t > 5000000 + SAMPLE_US){
+            CHECK(snap.rateMHz <= prev);
+            if(snap.rateMHz == 0 && zeroAt == 0) zeroAt = t;
+        }
+        prev = snap.rateMHz;
+    }
+    CHECK(zeroAt != 0 && zeroAt <= 5000000 + cfg.timeoutUs + SAMPLE_US);
+    CHECK_EQ(snap.totalMl, wantMl(src.pulses));
+    CHECK_EQ(snap.flowMlMin, 0);
+}
+
+//0 to 10 kHz in 20 s with jitter: the window averages, so compare with the
+//true rate half a window back
+static void testRamp(void){
+    flowCalc_t fc;
+    flowSnap_t snap;
+    source_t src;
+    double worst = 0;
+
+    flowCalcInit(&fc, &cfg);
+    sourceStart(&src, ramp, 0.1, 0);
+    for(uint64_t t = SAMPLE_US; t <= 25000000; t += SAMPLE_US){
+        sourceRun(&src, t);
+        flowCalcAdd(&fc, src.pulses, src.edgeUs, t, &snap);
+        CHECK_EQ(snap.totalMl, wantMl(src.pulses));
+        if(t < 2000000) continue;
+        double want = ramp(t / 1e6 - 0.5);
+        double err = fabs(snap.rateMHz / 1000.0 - want) / want;
+        if(err > worst) worst = err;
+    }
+    printf("ramp to 10 kHz: worst rate error %.3f%%\n", worst * 100);
+    CHECK(worst <= 0.04);
+}
+
+//10 kHz for 5 days is 4.32e9 pulses: the 32-bit count wraps, the volume must not
+static void testWrap(void){
+    flowCalc_t fc;
+    flowSnap_t snap;
+    uint64_t pulses = 0, lastMl = 0;
+    bool wrapped = false;
+
+    flowCalcInit(&fc, &cfg);
+    for(uint64_t t = SAMPLE_US; t <= 5ull * 86400 * 1000000; t += SAMPLE_US){
+        pulses = t / 100;                       //one every 100 us, last one right now
+        flowCalcAdd(&fc, (uint32_t)pulses, pulses * 100, t, &snap);
+        if(snap.totalMl < lastMl) break;
+        lastMl = snap.totalMl;
+        if(pulses > 0xffffffffu && !wrapped){
+            wrapped = true;
+            CHECK_EQ(snap.pulses, (uint32_t)pulses);
+            CHECK_EQ(snap.rateMHz, 10000000);
+        }
+    }
+    CHECK(wrapped);
+    CHECK_EQ(snap.totalMl, wantMl(pulses));
+    CHECK_EQ(snap.rateMHz, 10000000);
+}
+
+//a new K-factor counts from then on, the volume so far doesn't move
+static void testNewK(void){
+    flowCalc_t fc;
+    flowSnap_t snap;
+    uint64_t before;
+
+    flowCalcInit(&fc, &cfg);
+    flowCalcAdd(&fc, 45000, 0, SAMPLE_US, &snap);
+    CHECK_EQ(snap.totalMl, 100000);
+    fc.cfg.kMilli = 2 * K_MILLI;                //what flowSetK() does
+    flowCalcAdd(&fc, 45000, 0, 2 * SAMPLE_US, &snap);
+    CHECK_EQ(snap.totalMl, 100000);
+    flowCalcAdd(&fc, 45900, 0, 3 * SAMPLE_US, &snap);
+    CHECK_EQ(snap.totalMl, 101000);
+    before = snap.totalMl;
+    fc.cfg.kMilli = K_MILLI / 2;
+    flowCalcAdd(&fc, 45900, 0, 4 * SAMPLE_US, &snap);
+    CHECK_EQ(snap.totalMl, before);
+}
+
+int main(void){
+    testSteady(50, 0.08);
+    testSteady(1000, 0.012);
+    testSteady(10000, 0.004);
+    testStop();
+    testRamp();
+    testWrap();
+    testNewK();
+    return checkDone("flowCalc");
+}
@@ -0,0 +1,119 @@
+//outHeap against a brute-force model: random sets, moves and removes, and
+//after each one the heap's earliest edge must be the one a linear scan finds
+
+#include <string.h>
+#include "outHeap.h"
+#include "check.h"
+
+#define OPS 200000
+
+typedef struct {
+    bool queued;
+    uint64_t at;
+    uint8_t prio;
+} model_t;
+
+static outHeap_t heap;
+static model_t model[OUT_MAX_CH];
+
+static uint32_t rnd(void){
+    static uint32_t x = 2463534242u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+//a goes before b: earlier, then higher priority, then lower channel
+static bool before(int a, int b){
+    if(model[a].at != model[b].at) return model[a].at < model[b].at;
+    if(model[a].prio != model[b].prio) return model[a].prio > model[b].prio;
+    return a < b;
+}
+
+static int modelFirst(void){
+    int best = -1;
+    for(int ch = 0; ch < OUT_MAX_CH; ch++){
+        if(model[ch].queued && (best < 0 || before(ch, best))) best = ch;
+    }
+    return best;
+}
+
+static void checkPeek(void){
+    outEdge_t e;
+    int want = modelFirst();
+
+    if(want < 0){
+        CHECK(!outHeapPeek(&heap, &e));
+        return;
+    }
+    CHECK(outHeapPeek(&heap, &e));
+    CHECK_EQ(e.ch, want);
+    CHECK_EQ(e.at, model[want].at);
+    CHECK_EQ(e.prio, model[want].prio);
+}
+
+static void testRandom(void){
+    int queued = 0, fails = checkFails;
+
+    outHeapInit(&heap);
+    memset(model, 0, sizeof(model));
+    checkPeek();
+    for(int i = 0; i < OPS && checkFails == fails; i++){
+        uint8_t ch = rnd() % OUT_MAX_CH;
+        uint32_t op = rnd() % 10;
+
+        if(op < 6){             //set or move, few distinct times so ties are common
+            model[ch].queued = true;
+            model[ch].at = rnd() % 64;
+            model[ch].prio = rnd() % 4;
+            outHeapSet(&heap, ch, model[ch].at, model[ch].prio);
+        }else if(op < 9){
+            model[ch].queued = false;
+            outHeapRemove(&heap, ch);
+        }else{                  //what the scheduler does: step the earliest channel on
+            int first = modelFirst();
+            if(first >= 0){
+                model[first].at += 1 + rnd() % 16;
+                outHeapSet(&heap, first, model[first].at, model[first].prio);
+            }
+        }
+        queued = 0;
+        for(int c = 0; c < OUT_MAX_CH; c++) queued += model[c].queued;
+        CHECK_EQ(heap.n, queued);
+        checkPeek();
+    }
+}
+
+//draining by remove-the-first gives every channel in order
+static void testDrain(void){
+    outEdge_t e, prev;
+    int n = 0;
+
+    outHeapInit(&heap);
+    memset(model, 0, sizeof(model));
+    for(int ch = OUT_MAX_CH - 1; ch >= 0; ch--){
+        model[ch].at = rnd() % 8;
+        model[ch].prio = rnd() % 3;
+        outHeapSet(&heap, ch, model[ch].at, model[ch].prio);
+    }
+    while(outHeapPeek(&heap, &e)){
+        if(n){
+            bool ordered = prev.at < e.at || (prev.at == e.at && (prev.prio > e.prio ||
+                           (prev.prio == e.prio && prev.ch < e.ch)));
+            CHECK(ordered);
+        }
+        prev = e;
+        outHeapRemove(&heap, e.ch);
+        n++;
+    }
+    CHECK_EQ(n, OUT_MAX_CH);
+    outHeapRemove(&heap, 0);            //not queued: nothing happens
+    CHECK_EQ(heap.n, 0);
+}
+
+int main(void){
+    testRandom();
+    testDrain();
+    return checkDone("outHeap");
+}
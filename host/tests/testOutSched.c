@@ -0,0 +1,121 @@
+//outSched against a fake timer whose counter moves on with every edge put out,
+//the way a real batch costs time. No interrupt may put out more than
+//OUT_MAX_EDGES, the alarm must always be left ahead of the counter, a held
+//off interrupt must be caught up, and the jitter must count what a batch took.
+
+#include "driver/gpio.h"
+#include "driver/timer.h"
+#include "outSched.h"
+#include "check.h"
+
+#define EDGE_US  5                      //what one edge costs, a cold cache
+#define SAME     32                     //channels with the same pattern, due together
+
+static void (*isr)(void *);
+static void *isrArg;
+static uint64_t counterUs, alarmAt;
+static bool alarmOn;
+static uint32_t costUs, writes;
+
+//------------------------------ fake drivers ---------------------------------
+esp_err_t timer_init(timer_group_t group, timer_idx_t idx, const timer_config_t *config){ return ESP_OK; }
+esp_err_t timer_start(timer_group_t group, timer_idx_t idx){ return ESP_OK; }
+esp_err_t timer_enable_intr(timer_group_t group, timer_idx_t idx){ return ESP_OK; }
+esp_err_t timer_set_counter_value(timer_group_t group, timer_idx_t idx, uint64_t load_val){
+    counterUs = load_val;
+    return ESP_OK;
+}
+esp_err_t timer_isr_register(timer_group_t group, timer_idx_t idx, void (*fn)(void *), void *arg,
+                             int intr_alloc_flags, timer_isr_handle_t *handle){
+    isr = fn;
+    isrArg = arg;
+    return ESP_OK;
+}
+void timer_group_clr_intr_status_in_isr(timer_group_t group, timer_idx_t idx){}
+void timer_group_enable_alarm_in_isr(timer_group_t group, timer_idx_t idx){ alarmOn = true; }
+uint64_t timer_group_get_counter_value_in_isr(timer_group_t group, timer_idx_t idx){ return counterUs; }
+void timer_group_set_alarm_value_in_isr(timer_group_t group, timer_idx_t idx, uint64_t alarm_val){
+    alarmAt = alarm_val;
+}
+
+void gpio_pad_select_gpio(uint8_t gpio_num){}
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode){ return ESP_OK; }
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level){
+    writes++;
+    counterUs += costUs;
+    return ESP_OK;
+}
+
+//---------------------------------- tests ------------------------------------
+typedef struct {
+    uint32_t isrs;
+    uint32_t mostEdges;             //in one interrupt
+    uint32_t missed;                //alarm left behind the counter: would never fire
+    uint64_t onTimeAt;              //first interrupt after "from" that wasn't late
+} run_t;
+
+//the timer hardware: fire the alarm when the counter gets there, up to "untilUs".
+//"holdOffUs": the first interrupt comes that much late, like during a flash erase.
+static void run(run_t *r, uint64_t untilUs, uint64_t holdOffUs){
+    uint64_t from = counterUs;
+
+    while(alarmOn && alarmAt <= untilUs){
+        if(alarmAt + holdOffUs > counterUs){
+            counterUs = alarmAt + holdOffUs;                 //idle until then
+            if(!holdOffUs && !r->onTimeAt && counterUs > from) r->onTimeAt = counterUs;
+        }
+        holdOffUs = 0;
+        alarmOn = false;                                    //fired, the ISR turns it back on
+        writes = 0;
+        isr(isrArg);
+        r->isrs++;
+        if(writes > r->mostEdges) r->mostEdges = writes;
+        if(!alarmOn || alarmAt <= counterUs){
+            r->missed++;
+            break;
+        }
+    }
+    if(counterUs < untilUs) counterUs = untilUs;
+}
+
+int main(void){
+    outStats_t st;
+    run_t r = { 0 };
+    uint64_t start;
+
+    //set up at no cost, so the first SAME channels all start at the same count
+    outSetup();
+    for(int i = 0; i < OUT_MAX_CH; i++){
+        int ch = outAdd((gpio_num_t)(i % 32), i % 4, NULL);
+        blinkReq_t req = { .count = 2, .onUs = 3000, .offUs = 2000, .gapUs = 10000, .repeat = 1000000 };
+        if(i >= SAME){
+            req.onUs += 1000 * (i % 7) + 13 * i;
+            req.offUs += 700 * (i % 5) + 29 * i;
+        }
+        CHECK(outPlay(ch, &req));
+    }
+    CHECK(alarmOn);
+
+    //a second of it, every edge costs time: SAME edges at once are one full batch
+    costUs = EDGE_US;
+    run(&r, counterUs + 1000000, 0);
+    outGetStats(&st);
+    printf("%u interrupts, most %u edges in one, jitter max %u us\n", r.isrs, r.mostEdges, st.jitterMaxUs);
+    CHECK(r.mostEdges <= OUT_MAX_EDGES);
+    CHECK_EQ(r.missed, 0);
+    CHECK(st.jitterMaxUs >= EDGE_US * (SAME - 1));          //the last of a batch went out that late
+
+    //held off for 20 ms: a few hundred edges overdue. They go out OUT_MAX_EDGES
+    //at a time, and the timer is back on time within a few ms.
+    r = (run_t){ 0 };
+    start = counterUs;
+    run(&r, start + 1000000, 20000);
+    outGetStats(&st);
+    printf("after a 20 ms hold off: %u interrupts, most %u edges in one, on time again %lld us later\n",
+           r.isrs, r.mostEdges, r.onTimeAt ? (long long)(r.onTimeAt - start) - 20000 : -1);
+    CHECK(r.mostEdges <= OUT_MAX_EDGES);
+    CHECK_EQ(r.missed, 0);
+    CHECK(r.onTimeAt != 0 && r.onTimeAt - start < 20000 + 5000);
+    CHECK(st.jitterMaxUs >= 20000);
+    return checkDone("outSched");
+}
@@ -0,0 +1,108 @@
+//perfRing and perfHist: events come out in order and whole, a full ring drops
+//and counts, a claimed but unwritten slot holds the reader, percentiles bound
+//the values
+
+#include <string.h>
+#include "perfRing.h"
+#include "check.h"
+
+static perfRing_t ring;
+
+static void testOrder(void){
+    perfEvt_t e;
+
+    memset(&ring, 0, sizeof(ring));
+    CHECK(!perfRingPop(&ring, &e));
+    //a few laps, so head and tail wrap the slots
+    for(uint32_t i = 0; i < 3 * PERF_RING_LEN; i++){
+        CHECK(perfRingPush(&ring, i * 7, 1 + i % 5, i & 0xff, i));
+        CHECK(perfRingPop(&ring, &e));
+        CHECK_EQ(e.cycles, i * 7);
+        CHECK_EQ(e.type, 1 + i % 5);
+        CHECK_EQ(e.id, i & 0xff);
+        CHECK_EQ(e.arg, i & 0xffff);
+    }
+    CHECK(!perfRingPop(&ring, &e));
+    CHECK_EQ(ring.drops, 0);
+}
+
+static void testFull(void){
+    perfEvt_t e;
+    int pushed = 0;
+
+    memset(&ring, 0, sizeof(ring));
+    for(int i = 0; i < PERF_RING_LEN; i++) pushed += perfRingPush(&ring, i, 1, 0, 0);
+    //a few slots stay spare for writers that were interrupted mid-push
+    CHECK(pushed < PERF_RING_LEN);
+    CHECK(pushed >= PERF_RING_LEN - 8);
+    CHECK_EQ(ring.drops, PERF_RING_LEN - pushed);
+    for(int i = 0; i < pushed; i++){
+        CHECK(perfRingPop(&ring, &e));
+        CHECK_EQ(e.cycles, i);
+    }
+    CHECK(!perfRingPop(&ring, &e));
+    CHECK(perfRingPush(&ring, 1, 1, 0, 0));
+}
+
+//a writer that claimed a slot and was interrupted: what the ISR pushed after it
+//waits until the slot is written
+static void testClaimed(void){
+    perfEvt_t e;
+
+    memset(&ring, 0, sizeof(ring));
+    ring.head++;                                    //claimed, type still 0
+    CHECK(perfRingPush(&ring, 2, 3, 0, 0));         //the ISR's event
+    CHECK(!perfRingPop(&ring, &e));
+    ring.evt[0].cycles = 1;
+    __atomic_store_n(&ring.evt[0].type, 2, __ATOMIC_RELEASE);
+    CHECK(perfRingPop(&ring, &e));
+    CHECK_EQ(e.cycles, 1);
+    CHECK(perfRingPop(&ring, &e));
+    CHECK_EQ(e.cycles, 2);
+    CHECK(!perfRingPop(&ring, &e));
+}
+
+static void testHist(void){
+    perfHist_t h;
+
+    perfHistReset(&h);
+    CHECK_EQ(h.count, 0);
+    CHECK_EQ(perfHistPercentile(&h, 50), 0);
+
+    perfHistAdd(&h, 0);
+    perfHistAdd(&h, 1);
+    perfHistAdd(&h, 0xffffffffu);
+    CHECK_EQ(h.bin[0], 1);
+    CHECK_EQ(h.bin[1], 1);
+    CHECK_EQ(h.bin[32], 1);
+    CHECK_EQ(h.min, 0);
+    CHECK_EQ(h.max, 0xffffffffu);
+    CHECK_EQ(perfHistPercentile(&h, 100), 0xffffffffu);
+
+    //100 values 1..100: a percentile is the top of its bin, never above the max
+    perfHistReset(&h);
+    for(uint32_t v = 1; v <= 100; v++) perfHistAdd(&h, v);
+    CHECK_EQ(h.count, 100);
+    CHECK_EQ(h.sum, 5050);
+    CHECK_EQ(h.min, 1);
+    CHECK_EQ(h.max, 100);
+    CHECK_EQ(h.bin[7], 37);                         //64..100
+    CHECK_EQ(perfHistPercentile(&h, 1), 1);
+    CHECK_EQ(perfHistPercentile(&h, 3), 3);         //bin 2 is 2..3
+    CHECK_EQ(perfHistPercentile(&h, 50), 63);       //bin 6 is 32..63
+    CHECK_EQ(perfHistPercentile(&h, 63), 63);
+    CHECK_EQ(perfHistPercentile(&h, 64), 100);
+    CHECK_EQ(perfHistPercentile(&h, 99), 100);
+    for(int p = 0; p <= 100; p++){
+        uint32_t v = perfHistPercentile(&h, p);
+        CHECK(v >= (uint32_t)p && v <= 100);
+    }
+}
+
+int main(void){
+    testOrder();
+    testFull();
+    testClaimed();
+    testHist();
+    return checkDone("perfRing");
+}
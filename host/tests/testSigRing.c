@@ -0,0 +1,133 @@
+//sigRing: many producer threads against one consumer. Every count must come
+//out exactly once, merged or not, every value in order per producer, and the
+//statistics must add up.
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include "sigRing.h"
+#include "check.h"
+
+#define PRODUCERS   4
+#define POSTS       100000          //per producer
+#define SLOTS       16
+#define VAL_FLAG    (SIGRING_COUNT_MAX + 1)     //like BLINK_SIG_PATTERN
+
+SIGRING_DEFINE(ring, SLOTS);
+
+typedef struct {
+    int id;
+    uint64_t countSum;      //counts posted
+    uint32_t counts;        //sigRingPostCount calls
+    uint32_t values;        //sigRingTryPost calls
+    uint32_t failed;        //of those, refused
+} producer_t;
+
+static producer_t prod[PRODUCERS];
+static uint32_t running, go;
+
+//odd posts are counts, even ones are values carrying (producer, sequence)
+static void *producer(void *arg){
+    producer_t *p = arg;
+    uint32_t rnd = 12345 + p->id, seq = 0;
+
+    while(!__atomic_load_n(&go, __ATOMIC_ACQUIRE));
+    for(int i = 0; i < POSTS; i++){
+        rnd = rnd * 1103515245 + 12345;
+        for(volatile int spin = rnd >> 26; spin; spin--);     //a little work between posts
+        if((i & 7) == 0) sched_yield();                     //let the consumer in on one CPU too
+        if(i & 1){
+            uint32_t count = 1 + (rnd >> 16) % 100;
+            sigRingPostCount(&ring, count);
+            p->countSum += count;
+            p->counts++;
+        }else{
+            p->values++;
+            if(sigRingTryPost(&ring, VAL_FLAG | p->id << 24 | (seq & 0xffffff))) seq++;
+            else p->failed++;
+        }
+    }
+    __atomic_fetch_sub(&running, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void testStress(void){
+    pthread_t th[PRODUCERS];
+    uint32_t nextSeq[PRODUCERS] = { 0 }, val, got = 0, coalesced = 0, failed = 0, counts = 0;
+    uint64_t countSum = 0, wantSum = 0;
+    bool more = true;
+
+    sigRingInit(&ring, ringSlots, SLOTS);
+    running = PRODUCERS;
+    for(int i = 0; i < PRODUCERS; i++){
+        prod[i].id = i;
+        pthread_create(&th[i], NULL, producer, &prod[i]);
+    }
+    __atomic_store_n(&go, 1, __ATOMIC_RELEASE);
+    //take until the producers are done and the ring is empty
+    while(more){
+        more = __atomic_load_n(&running, __ATOMIC_ACQUIRE) != 0;
+        while(sigRingTake(&ring, &val)){
+            if(val & VAL_FLAG){
+                int id = (val >> 24) & 0x7f;
+                CHECK(id < PRODUCERS);
+                CHECK_EQ(val & 0xffffff, nextSeq[id] & 0xffffff);
+                nextSeq[id]++;
+                got++;
+            }else{
+                countSum += val;
+            }
+            more = true;
+        }
+        sched_yield();
+    }
+    for(int i = 0; i < PRODUCERS; i++){
+        pthread_join(th[i], NULL);
+        wantSum += prod[i].countSum;
+        counts += prod[i].counts;
+        failed += prod[i].failed;
+        CHECK_EQ(nextSeq[i], prod[i].values - prod[i].failed);
+    }
+    coalesced = ring.coalesced;
+
+    CHECK(sigRingEmpty(&ring));
+    CHECK_EQ(countSum, wantSum);
+    CHECK_EQ(ring.drops, failed);
+    //every post went into a slot, or was merged, or was dropped
+    CHECK_EQ(ring.posted + coalesced + ring.drops, PRODUCERS * POSTS);
+    CHECK_EQ(ring.posted, got + counts - coalesced);
+    CHECK(ring.hiWater <= SLOTS);
+    printf("stress: %d producers, %u posted, %u coalesced, %u dropped, hiWater %u\n",
+           PRODUCERS, ring.posted, coalesced, ring.drops, ring.hiWater);
+}
+
+//merged counts stop short of bit 31 however much piles up
+static void testSaturate(void){
+    uint32_t val;
+
+    sigRingInit(&ring, ringSlots, SLOTS);
+    for(int i = 0; i < SLOTS; i++) CHECK(sigRingTryPost(&ring, i));
+    sigRingPostCount(&ring, 0x7ffffff0u);
+    sigRingPostCount(&ring, 0x7ffffff0u);
+    sigRingPostCount(&ring, 0xffffffffu);
+    CHECK_EQ(ring.coalesced, 3);
+    for(int i = 0; i < SLOTS; i++){
+        CHECK(sigRingTake(&ring, &val));
+        CHECK_EQ(val, i);
+    }
+    CHECK(sigRingTake(&ring, &val));
+    CHECK_EQ(val, SIGRING_COUNT_MAX);
+    CHECK(!sigRingTake(&ring, &val));
+
+    //a single count that big is clamped too, in a slot
+    sigRingPostCount(&ring, 0x90000000u);
+    CHECK(sigRingTake(&ring, &val));
+    CHECK_EQ(val, SIGRING_COUNT_MAX);
+    CHECK(sigRingEmpty(&ring));
+}
+
+int main(void){
+    testSaturate();
+    testStress();
+    return checkDone("sigRing");
+}
@@ -0,0 +1,87 @@
+//taskTableCheck: tables with one kind of problem each must report exactly
+//those, and good tables none. g02sim -c checks the app's own table.
+
+#include "taskTable.h"
+#include "check.h"
+
+#define N(t) (int)(sizeof(t) / sizeof(t[0]))
+
+static void fn(void *p){}
+
+//name, function, core, prio, stack, period ms, budget us
+static const taskDef_t good[] = {
+    { "fast",  fn, TASK_CORE_APP, 5, 2048,   10, 2000, NULL },
+    { "mid",   fn, TASK_CORE_PRO, 3, 2048,  100, 5000, NULL },
+    { "slow",  fn, TASK_CORE_ANY, 1, 4096, 1000, 50000, NULL },
+    { "idle",  fn, TASK_CORE_PRO, 2, 2048,    0,    0, NULL },     //nothing to check
+};
+
+//a 10 ms task below a 100 ms one on the same core
+static const taskDef_t inversion[] = {
+    { "often", fn, TASK_CORE_PRO, 2, 2048,  10, 100, NULL },
+    { "rare",  fn, TASK_CORE_PRO, 3, 2048, 100, 100, NULL },
+};
+static const taskDef_t inversionApart[] = {
+    { "often", fn, TASK_CORE_PRO, 2, 2048,  10, 100, NULL },
+    { "rare",  fn, TASK_CORE_APP, 3, 2048, 100, 100, NULL },
+};
+static const taskDef_t inversionAny[] = {
+    { "often", fn, TASK_CORE_PRO, 2, 2048,  10, 100, NULL },
+    { "rare",  fn, TASK_CORE_ANY, 3, 2048, 100, 100, NULL },
+};
+
+//105% of core 1: the core is over, and "second" can't finish in time either
+static const taskDef_t overload[] = {
+    { "first",  fn, TASK_CORE_APP, 5, 2048, 10, 6000, NULL },
+    { "second", fn, TASK_CORE_APP, 4, 2048, 20, 9000, NULL },
+    { "other",  fn, TASK_CORE_PRO, 4, 2048, 20, 9000, NULL },
+};
+
+//93% of a core, but "late" is preempted twice within its 14 ms: 16 ms
+static const taskDef_t miss[] = {
+    { "early", fn, TASK_CORE_PRO, 5, 2048, 10, 5000, NULL },
+    { "late",  fn, TASK_CORE_PRO, 4, 2048, 14, 6000, NULL },
+};
+
+//woken by events with a budget but no bound on how often: can't be counted
+static const taskDef_t noPeriod[] = {
+    { "tick",  fn, TASK_CORE_PRO, 1, 2048, 100, 1000, NULL },
+    { "event", fn, TASK_CORE_PRO, 2, 2048,   0,  500, NULL },
+};
+
+//an event task with its shortest gap counts like any other: "bulk" alone is
+//60% of core 0, with "event" it's 110% and "bulk" can miss
+static const taskDef_t eventLoad[] = {
+    { "bulk",  fn, TASK_CORE_PRO, 1, 2048, 1000, 600000, NULL },
+    { "event", fn, TASK_CORE_PRO, 2, 2048,  100,  50000, NULL },
+};
+
+//fine at 240 MHz, 3 times slower at 80: core 0 goes to 105% and "b" misses
+static const taskDef_t clocked[] = {
+    { "a", fn, TASK_CORE_PRO, 5, 2048,  10, 3000, NULL },
+    { "b", fn, TASK_CORE_PRO, 4, 2048, 100, 5000, NULL },
+};
+
+static const taskDef_t outOfRange[] = {
+    { "stack", fn, TASK_CORE_PRO,  1, 512, 100, 10, NULL },
+    { "prio",  fn, TASK_CORE_PRO, 25, 2048, 100, 10, NULL },
+    { "core",  fn, 2,              1, 2048, 100, 10, NULL },
+    { "long",  fn, TASK_CORE_APP,  1, 2048,   1, 1500, NULL },  //and the whole core, and misses
+};
+
+int main(void){
+    CHECK_EQ(taskTableCheck(good, N(good), 2, 240), 0);
+    CHECK_EQ(taskTableCheck(good, N(good), 2, 80), 0);
+    CHECK_EQ(taskTableCheck(inversion, N(inversion), 2, 240), 1);
+    CHECK_EQ(taskTableCheck(inversionApart, N(inversionApart), 2, 240), 0);
+    CHECK_EQ(taskTableCheck(inversionAny, N(inversionAny), 2, 240), 1);
+    CHECK_EQ(taskTableCheck(overload, N(overload), 2, 240), 2);
+    CHECK_EQ(taskTableCheck(miss, N(miss), 2, 240), 1);
+    CHECK_EQ(taskTableCheck(noPeriod, N(noPeriod), 2, 240), 1);
+    CHECK_EQ(taskTableCheck(eventLoad, N(eventLoad), 2, 240), 2);
+    CHECK_EQ(taskTableCheck(eventLoad, 1, 2, 240), 0);
+    CHECK_EQ(taskTableCheck(clocked, N(clocked), 2, 240), 0);
+    CHECK_EQ(taskTableCheck(clocked, N(clocked), 2, 80), 2);
+    CHECK_EQ(taskTableCheck(outOfRange, N(outOfRange), 2, 240), 6);
+    return checkDone("taskTable");
+}
@@ -0,0 +1,330 @@
+//telemCodec round trip from known samples: whatever goes into the encoder must
+//come out of the decoder exactly, at the extremes of every field, and the
+//decoder must count and get past corrupted, cut, repeated and late packets.
+//testTelemCodecBig.c builds it again with 600 byte packets for the long COBS runs.
+
+#include <string.h>
+#include "telemCodec.h"
+#include "check.h"
+
+#define MAX_SAMPLES 4096
+#define MAX_BYTES   (256 * 1024)
+
+typedef struct {
+    flowSnap_t s[MAX_SAMPLES];
+    uint16_t seq[MAX_SAMPLES];
+    int n;
+} got_t;
+
+static telemEnc_t enc;
+static telemDec_t dec;
+static got_t got;
+static uint8_t stream[MAX_BYTES];
+static size_t frameAt[MAX_SAMPLES];     //where each frame of the stream starts
+static int frames;
+
+static void onSample(void *arg, uint16_t seq, const flowSnap_t *s){
+    got_t *g = arg;
+    if(g->n < MAX_SAMPLES){
+        g->seq[g->n] = seq;
+        g->s[g->n++] = *s;
+    }
+}
+
+//encode the samples as the telemetry task does, "perFrame" at most per packet
+//(0 = as many as fit). Returns the stream length.
+static size_t encode(const flowSnap_t *s, int n, int perFrame){
+    size_t len = 0;
+
+    frames = 0;
+    for(int i = 0; i < n; i++){
+        if((perFrame && enc.count == perFrame) || !telemEncAdd(&enc, &s[i])){
+            frameAt[frames++] = len;
+            len += telemEncFrame(&enc, stream + len);
+            CHECK(telemEncAdd(&enc, &s[i]));
+        }
+    }
+    frameAt[frames++] = len;
+    len += telemEncFrame(&enc, stream + len);
+    frameAt[frames] = len;
+    return len;
+}
+
+static void decode(const uint8_t *data, size_t len){
+    telemDecInit(&dec);
+    memset(&got, 0, sizeof(got));
+    telemDecBytes(&dec, data, len, onSample, &got);
+}
+
+static bool same(const flowSnap_t *a, const flowSnap_t *b){
+    return a->atUs == b->atUs && a->pulses == b->pulses && a->rateMHz == b->rateMHz &&
+           a->flowMlMin == b->flowMlMin && a->totalMl == b->totalMl;
+}
+
+//the decoded samples are exactly "want"
+static void checkSamples(const flowSnap_t *want, int n){
+    int bad = 0;
+
+    CHECK_EQ(got.n, n);
+    for(int i = 0; i < n && i < got.n; i++) bad += !same(&got.s[i], &want[i]);
+    CHECK_EQ(bad, 0);
+}
+
+//no byte of a frame but the last is 0x00
+static void checkFraming(size_t len){
+    for(int f = 0; f < frames; f++){
+        size_t end = frameAt[f + 1] - 1;
+        int zeros = 0;
+        for(size_t i = frameAt[f]; i < end; i++) zeros += stream[i] == 0;
+        CHECK_EQ(zeros, 0);
+        CHECK_EQ(stream[end], 0);
+        CHECK(frameAt[f + 1] - frameAt[f] <= TELEM_FRAME_MAX);
+    }
+    CHECK_EQ(frameAt[frames], len);
+}
+
+//every field from nothing to its maximum and back: 10-byte varints, the
+//biggest negative deltas, and the 32-bit pulse count wrapping
+static void testExtremes(void){
+    static const flowSnap_t s[] = {
+        { 0, 0, 0, 0, 0 },
+        { UINT64_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT64_MAX },
+        { 0, 0, 0, 0, 0 },
+        { 1ull << 63, 0x80000000u, 1, 2, 1ull << 63 },
+        { (1ull << 63) - 1, 0xfffffff0u, 0, 0, (1ull << 63) - 1 },
+        { 1ull << 63, 0x10, 7, 8, 1ull << 63 },          //pulses wrapped by 32
+        { 1ull << 63, 0x10, 7, 8, 1ull << 63 },          //all deltas zero
+        { 123456789, 4000000000u, 99999, 12345, 42 },
+    };
+    const int n = sizeof(s) / sizeof(s[0]);
+    size_t len;
+
+    telemEncInit(&enc);
+    len = encode(s, n, 0);
+    checkFraming(len);
+    decode(stream, len);
+    checkSamples(s, n);
+    CHECK_EQ(dec.bad, 0);
+    CHECK_EQ(dec.lost, 0);
+
+    //one per packet: every packet starts against zero
+    telemEncInit(&enc);
+    len = encode(s, n, 1);
+    CHECK_EQ(frames, n);
+    checkFraming(len);
+    decode(stream, len);
+    checkSamples(s, n);
+    CHECK_EQ(dec.frames, n);
+}
+
+//a 10-byte varint per field, as many as fit, then small ones to the brim
+static void testFullPacket(void){
+    static flowSnap_t s[64];
+    size_t len;
+    int n = 0;
+
+    telemEncInit(&enc);
+    while(n < 64){
+        flowSnap_t *p = &s[n];
+        *p = n ? s[n - 1] : (flowSnap_t){ 0 };
+        if(n % 2 == 0){
+            p->atUs += 1ull << 63;
+            p->totalMl ^= 1ull << 63;
+        }else{
+            p->atUs += 1;
+        }
+        if(!telemEncAdd(&enc, p)) break;
+        n++;
+    }
+    CHECK(enc.len > TELEM_PAYLOAD_MAX - TELEM_SAMPLE_MAX);
+    CHECK(enc.len <= TELEM_PAYLOAD_MAX);
+
+    len = telemEncFrame(&enc, stream);
+    CHECK(len <= TELEM_FRAME_MAX);
+    decode(stream, len);
+    checkSamples(s, n);
+    CHECK_EQ(dec.frames, 1);
+}
+
+//seq numbers wrap at 16 bits without a packet counted lost
+static void testSeqWrap(void){
+    static flowSnap_t s[40];
+    size_t len;
+
+    for(int i = 0; i < 40; i++) s[i] = (flowSnap_t){ 100000ull * i, 5 * i, 50000, 6666, 11 * i };
+    telemEncInit(&enc);
+    enc.seq = 0xffff - 20;
+    len = encode(s, 40, 1);
+    decode(stream, len);
+    checkSamples(s, 40);
+    CHECK_EQ(got.seq[20], 0xffff);
+    CHECK_EQ(got.seq[21], 0);
+    CHECK_EQ(dec.lost, 0);
+    CHECK_EQ(dec.resync, 0);
+}
+
+//a flowing sensor, 3 samples per packet: 10 packets
+static size_t tenPackets(flowSnap_t *s){
+    for(int i = 0; i < 30; i++) s[i] = (flowSnap_t){ 100000ull * i, 50 * i, 500000, 66666, 111 * i };
+    telemEncInit(&enc);
+    return encode(s, 30, 3);
+}
+
+static void testCorruptAndCut(void){
+    static flowSnap_t s[30];
+    static uint8_t bent[MAX_BYTES];
+    size_t len = tenPackets(s), n = 0;
+
+    CHECK_EQ(frames, 10);
+    //packet 2 gets a bit flipped (never to 0x00), packet 5 loses its second
+    //half and its end, so it runs into packet 6 and takes it down too
+    for(int f = 0; f < frames; f++){
+        size_t from = frameAt[f], flen = frameAt[f + 1] - from;
+        if(f == 5) flen /= 2;
+        memcpy(bent + n, stream + from, flen);
+        if(f == 2) bent[n + flen / 2] = bent[n + flen / 2] == 0x01 ? 0x03 : bent[n + flen / 2] ^ 0x01;
+        n += flen;
+    }
+    decode(bent, n);
+    CHECK_EQ(dec.bad, 2);
+    CHECK_EQ(dec.lost, 3);
+    CHECK_EQ(dec.frames, 7);
+    CHECK_EQ(got.n, 21);
+    for(int i = 0, k = 0; i < 30 && k < got.n; i++){
+        int f = i / 3;
+        if(f == 2 || f == 5 || f == 6) continue;
+        CHECK(same(&got.s[k], &s[i]));
+        CHECK_EQ(got.seq[k], f);
+        k++;
+    }
+
+    //joining in the middle of a packet: that one is bad, nothing counted lost
+    decode(stream + frameAt[0] + 3, len - frameAt[0] - 3);
+    CHECK_EQ(dec.bad, 1);
+    CHECK_EQ(dec.lost, 0);
+    CHECK_EQ(dec.frames, 9);
+    checkSamples(s + 3, 27);
+
+    //a stream cut short: the unfinished packet is not decoded
+    decode(stream, frameAt[9] + 4);
+    CHECK_EQ(dec.frames, 9);
+    CHECK_EQ(dec.bad, 0);
+    CHECK_EQ(got.n, 27);
+}
+
+//a repeated or late packet is a resync, not 65535 lost ones
+static void testDuplicates(void){
+    static flowSnap_t s[30];
+    static uint8_t mixed[MAX_BYTES];
+    static const int order[] = { 0, 1, 2, 3, 4, 3, 5, 7, 6, 8, 9 };
+    size_t n = 0;
+
+    tenPackets(s);
+    for(int i = 0; i < (int)(sizeof(order) / sizeof(order[0])); i++){
+        int f = order[i];
+        memcpy(mixed + n, stream + frameAt[f], frameAt[f + 1] - frameAt[f]);
+        n += frameAt[f + 1] - frameAt[f];
+    }
+    decode(mixed, n);
+    CHECK_EQ(dec.frames, 11);
+    CHECK_EQ(dec.bad, 0);
+    CHECK_EQ(dec.resync, 2);            //the second 3, and 6 after 7
+    CHECK_EQ(dec.lost, 1);              //6 looked lost when 7 came
+    CHECK_EQ(got.n, 33);
+}
+
+//50 packets from seq "firstSeq" in session 7, then the sender reboots into
+//"session" with seq 0 and sends 40 more, of which packet "drop" is lost
+static void restart(uint16_t firstSeq, uint8_t session, int drop, uint32_t wantLost){
+    static flowSnap_t s[90];
+    static uint8_t both[MAX_BYTES];
+    size_t n;
+
+    for(int i = 0; i < 90; i++) s[i] = (flowSnap_t){ 100000ull * i, 50 * i, 500000, 66666, 111 * i };
+    telemEncInit(&enc);
+    enc.session = 7;
+    enc.seq = firstSeq;
+    n = encode(s, 50, 1);
+    memcpy(both, stream, n);
+    telemEncInit(&enc);
+    enc.session = session;
+    encode(s + 50, 40, 1);
+    for(int f = 0; f < frames; f++){
+        if(f == drop) continue;
+        memcpy(both + n, stream + frameAt[f], frameAt[f + 1] - frameAt[f]);
+        n += frameAt[f + 1] - frameAt[f];
+    }
+    decode(both, n);
+    CHECK_EQ(dec.frames, drop < 0 ? 90 : 89);
+    CHECK_EQ(dec.bad, 0);
+    CHECK_EQ(dec.resync, 1);
+    CHECK_EQ(dec.lost, wantLost);
+}
+
+//a reboot is followed at once, even when the new seq is just a little behind
+static void testRestart(void){
+    restart(0, 8, -1, 0);               //seq 49 then 0
+    restart(0, 8, 10, 1);               //a loss after the reboot still counts
+    restart(0, 8, 0, 0);                //its first packet lost: seq 49 then 1
+    restart(30000, 8, -1, 0);
+    restart(30000, 7, -1, 0);           //same session by chance: the seq is far enough
+}
+
+#if TELEM_PAYLOAD_MAX > 254
+//payloads with no zero byte for more than 254 bytes: COBS codes of 0xff
+static void testLongRuns(void){
+    static flowSnap_t s[200];
+    size_t len;
+    int n = 0, longest = 0, run = 0;
+
+    //every delta a non-zero single byte: dt 0x7f, the others +63 (zigzag 0x7e)
+    for(int i = 0; i < 200; i++){
+        s[i].atUs = 0x7full * (i + 1);
+        s[i].pulses = 63u * (i + 1);
+        s[i].rateMHz = 63u * (i + 1);
+        s[i].flowMlMin = 63u * (i + 1);
+        s[i].totalMl = 63ull * (i + 1);
+    }
+    telemEncInit(&enc);
+    enc.session = 0x5a;
+    enc.seq = 0x0101;                   //no zero in the header either
+    while(n < 200 && telemEncAdd(&enc, &s[n])) n++;
+    CHECK(enc.len > 2 * 254);
+    for(int i = 0; i < enc.len; i++){
+        run = enc.buf[i] ? run + 1 : 0;
+        if(run > longest) longest = run;
+    }
+    CHECK(longest > 254);
+    len = telemEncFrame(&enc, stream);
+    CHECK(len <= TELEM_FRAME_MAX);
+    decode(stream, len);
+    checkSamples(s, n);
+
+    //and on, across packets, exactly 254 and 255 byte payload runs included
+    for(int cut = 49; cut <= 52; cut++){
+        telemEncInit(&enc);
+        enc.session = 0x5a;
+        enc.seq = 0x0101;
+        len = encode(s, 200, cut);
+        checkFraming(len);
+        decode(stream, len);
+        checkSamples(s, 200);
+        CHECK_EQ(dec.bad, 0);
+    }
+}
+#endif
+
+int main(void){
+    testExtremes();
+    testFullPacket();
+    testSeqWrap();
+    testCorruptAndCut();
+    testDuplicates();
+    testRestart();
+#if TELEM_PAYLOAD_MAX > 254
+    testLongRuns();
+    return checkDone("telemCodec, 600 byte packets");
+#else
+    return checkDone("telemCodec");
+#endif
+}
@@ -0,0 +1,3 @@
+//testTelemCodec.c again, built with TELEM_PAYLOAD_MAX=600 (see CMakeLists.txt)
+//so the COBS encoder sees runs of more than 254 non-zero bytes
+#include "testTelemCodec.c"
@@ -0,0 +1,140 @@
+//telemdec: decode the telemetry stream (telemCodec.h) from a file or stdin.
+//Prints one CSV line per sample, the counts go to stderr.
+//
+//  g02sim -t 600 -f 50 -u telem.bin -q && telemdec telem.bin
+//  telemdec -b -q telem.bin        re-encode the recorded samples: bytes and time
+//                                  per sample. host/tests/testTelemCodec.c is the
+//                                  round trip test from known samples.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "telemCodec.h"
+
+#define BENCH_PASSES 200
+
+typedef struct {
+    flowSnap_t *s;
+    size_t n, cap;
+} trace_t;
+
+static bool printCsv = true;
+
+static void onSample(void *arg, uint16_t seq, const flowSnap_t *s){
+    trace_t *t = arg;
+
+    if(printCsv){
+        printf("%u,%llu,%u,%u,%u,%llu\n", seq, (unsigned long long)s->atUs, s->pulses, s->rateMHz,
+               s->flowMlMin, (unsigned long long)s->totalMl);
+    }
+    if(!t) return;
+    if(t->n == t->cap){
+        t->cap = t->cap ? 2 * t->cap : 1024;
+        t->s = realloc(t->s, t->cap * sizeof(*t->s));
+    }
+    t->s[t->n++] = *s;
+}
+
+static double nowNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+//encode the whole trace the way the firmware does, into "out" if not NULL. Returns the bytes.
+static size_t encodeAll(const trace_t *t, uint8_t *out){
+    static telemEnc_t enc;
+    uint8_t frame[TELEM_FRAME_MAX];
+    size_t total = 0, n;
+
+    telemEncInit(&enc);
+    for(size_t i = 0; i < t->n; i++){
+        if(!telemEncAdd(&enc, &t->s[i])){
+            n = telemEncFrame(&enc, frame);
+            if(out) memcpy(out + total, frame, n);
+            total += n;
+            telemEncAdd(&enc, &t->s[i]);
+        }
+    }
+    n = telemEncFrame(&enc, frame);
+    if(out) memcpy(out + total, frame, n);
+    return total + n;
+}
+
+static int bench(const trace_t *t){
+    trace_t back = { 0 };
+    telemDec_t dec;
+    uint8_t *buf;
+    size_t bytes;
+    double t0, encNs, decNs;
+    bool same;
+
+    if(t->n == 0){
+        fprintf(stderr, "no samples to benchmark\n");
+        return 1;
+    }
+    bytes = encodeAll(t, NULL);
+    buf = malloc(bytes);
+    encodeAll(t, buf);
+
+    printCsv = false;
+    telemDecInit(&dec);
+    telemDecBytes(&dec, buf, bytes, onSample, &back);
+    same = back.n == t->n && memcmp(back.s, t->s, t->n * sizeof(*t->s)) == 0;
+
+    t0 = nowNs();
+    for(int i = 0; i < BENCH_PASSES; i++) encodeAll(t, buf);
+    encNs = (nowNs() - t0) / BENCH_PASSES / t->n;
+    t0 = nowNs();
+    for(int i = 0; i < BENCH_PASSES; i++){
+        telemDecInit(&dec);
+        telemDecBytes(&dec, buf, bytes, NULL, NULL);
+    }
+    decNs = (nowNs() - t0) / BENCH_PASSES / t->n;
+
+    fprintf(stderr, "re-encode %s: %zu samples, %zu bytes, %.2f bytes/sample (raw %zu)\n",
+            same ? "ok" : "FAILED", t->n, bytes, (double)bytes / t->n, sizeof(flowSnap_t));
+    fprintf(stderr, "encode %.1f ns/sample, decode %.1f ns/sample on this machine\n", encNs, decNs);
+    free(buf);
+    free(back.s);
+    return same ? 0 : 1;
+}
+
+int main(int argc, char **argv){
+    trace_t trace = { 0 };
+    telemDec_t dec;
+    uint8_t buf[4096];
+    size_t n, bytes = 0;
+    bool doBench = false;
+    FILE *in = stdin;
+    int opt;
+
+    while((opt = getopt(argc, argv, "bqh")) != -1){
+        switch(opt){
+        case 'b': doBench = true; break;
+        case 'q': printCsv = false; break;
+        default:
+            printf("usage: %s [-b] [-q] [file]\n"
+                   "  -b  re-encode the samples: size and speed\n"
+                   "  -q  no CSV, counts only\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if(optind < argc && (in = fopen(argv[optind], "rb")) == NULL){
+        perror(argv[optind]);
+        return 1;
+    }
+
+    if(printCsv) printf("seq,atUs,pulses,rateMHz,flowMlMin,totalMl\n");
+    telemDecInit(&dec);
+    while((n = fread(buf, 1, sizeof(buf), in)) > 0){
+        telemDecBytes(&dec, buf, n, onSample, doBench ? &trace : NULL);
+        bytes += n;
+    }
+    fprintf(stderr, "%zu bytes, %u packets, %u samples, %u bad, %u lost, %u resync, %.2f bytes/sample\n",
+            bytes, dec.frames, dec.samples, dec.bad, dec.lost, dec.resync,
+            dec.samples ? (double)bytes / dec.samples : 0.0);
+    return doBench ? bench(&trace) : 0;
+}
@@ -0,0 +1,58 @@
+//Blink pattern compiler and edge sequencer, see blinkWave.h
+
+#include <string.h>
+#include "blinkWave.h"
+
+//append a segment, merging with the previous one if the level doesn't change
+static void addSeg(blinkWave_t *wave, uint8_t level, uint32_t durUs){
+    if(durUs == 0) return;
+    if(wave->nSeg && wave->seg[wave->nSeg - 1].level == level){
+        wave->seg[wave->nSeg - 1].durUs += durUs;
+        return;
+    }
+    wave->seg[wave->nSeg].level = level;
+    wave->seg[wave->nSeg].durUs = durUs;
+    wave->nSeg++;
+}
+
+bool blinkCompile(const blinkReq_t *req, blinkWave_t *wave){
+    memset(wave, 0, sizeof(*wave));
+    if(req->count <= 0 || req->count > BLINK_MAX_COUNT || req->repeat <= 0) return false;
+
+    for(int i = 0; i < req->count; i++){
+        addSeg(wave, 1, req->onUs);
+        addSeg(wave, 0, req->offUs);
+    }
+    addSeg(wave, 0, req->gapUs);    //merges into the last off time
+
+    if(wave->nSeg == 0) return false;   //every duration was zero
+    for(int i = 0; i < wave->nSeg; i++){
+        if(wave->seg[i].durUs < BLINK_MIN_SEG_US) return false;
+    }
+    wave->repeat = req->repeat;
+    return true;
+}
+
+uint64_t blinkWaveUs(const blinkWave_t *wave){
+    uint64_t us = 0;
+    for(int i = 0; i < wave->nSeg; i++) us += wave->seg[i].durUs;
+    return us * wave->repeat;
+}
+
+void blinkSeqStart(blinkSeq_t *seq, const blinkWave_t *wave){
+    seq->wave = wave;
+    seq->idx = 0;
+    seq->pass = 0;
+}
+
+bool blinkSeqNext(blinkSeq_t *seq, blinkSeg_t *out){
+    const blinkWave_t *wave = seq->wave;
+    if(wave == NULL || seq->pass >= wave->repeat) return false;
+
+    *out = wave->seg[seq->idx];
+    if(++seq->idx >= wave->nSeg){
+        seq->idx = 0;
+        seq->pass++;
+    }
+    return true;
+}
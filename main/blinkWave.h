@@ -0,0 +1,58 @@
+#ifndef _BLINKWAVE_H_
+#define _BLINKWAVE_H_
+
+//Blink pattern compiler and edge sequencer.
+//Plain C, no ESP-IDF includes, so the timing logic builds and runs on a PC too.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BLINK_MAX_COUNT 16                  //blinks per burst
+#define BLINK_MAX_SEGS  (2 * BLINK_MAX_COUNT)
+#define BLINK_MIN_SEG_US 100                //shortest level the timer is asked to hold
+
+//what the caller asks for: "count" blinks, then "gapUs" of extra dark, all played "repeat" times
+typedef struct {
+    int count;
+    uint32_t onUs;
+    uint32_t offUs;
+    uint32_t gapUs;
+    int repeat;
+} blinkReq_t;
+
+//one steady output level held for durUs
+typedef struct {
+    uint32_t durUs;
+    uint8_t level;
+} blinkSeg_t;
+
+//precomputed waveform of one burst, replayed "repeat" times by the sequencer
+typedef struct {
+    blinkSeg_t seg[BLINK_MAX_SEGS];
+    uint8_t nSeg;
+    uint32_t repeat;
+} blinkWave_t;
+
+//playback cursor, small enough to live in an ISR's static data
+typedef struct {
+    const blinkWave_t *wave;
+    uint8_t idx;
+    uint32_t pass;
+} blinkSeq_t;
+
+//turn a request into a waveform. Zero-length segments are dropped and equal levels merged.
+//Returns false if the request is empty, count > BLINK_MAX_COUNT, or a merged
+//segment is shorter than BLINK_MIN_SEG_US: the timer ISR would spend its time
+//chasing edges it can't put out on time.
+bool blinkCompile(const blinkReq_t *req, blinkWave_t *wave);
+
+//total play time of a compiled wave in microseconds
+uint64_t blinkWaveUs(const blinkWave_t *wave);
+
+//rewind the cursor to the first segment
+void blinkSeqStart(blinkSeq_t *seq, const blinkWave_t *wave);
+
+//next segment to put on the pin, false once the wave is finished
+bool blinkSeqNext(blinkSeq_t *seq, blinkSeg_t *out);
+
+#endif
@@ -0,0 +1,13 @@
+#ifndef _CRC32_H_
+#define _CRC32_H_
+
+//CRC-32 as in zlib/Ethernet (reflected 0xEDB88320, init and final xor 0xffffffff).
+//Nibble table, 64 bytes of flash, fast enough for records and packets.
+
+#include <stdint.h>
+#include <stddef.h>
+
+//start with crc = 0, feed the data in as many pieces as you like
+uint32_t crc32Add(uint32_t crc, const void *data, size_t len);
+
+#endif
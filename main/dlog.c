@@ -0,0 +1,244 @@
+//Deferred logging, see dlog.h
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "perfStats.h"
+#include "dlog.h"
+
+#define DLOG_LINE  160
+#define DLOG_BATCH 512              //bytes per write to stdout
+
+typedef struct {
+    dlogRec_t rec[DLOG_RING_LEN];
+    uint32_t head;                  //claimed by writers
+    uint32_t tail;                  //owned by the drain
+    uint32_t full;                  //records lost to a full ring
+} dlogRing_t;
+
+//token bucket of one tag on one core. Only that core touches it, but a task and
+//the ISRs that interrupt it do: dlogLock[core] keeps them apart. The same lock
+//covers claiming a slot in that core's ring.
+typedef struct {
+    const char *tag;
+    uint16_t perSec;
+    uint16_t burst;
+    uint16_t tokens;
+    uint32_t lastMs;                //time the tokens were last topped up to
+    uint32_t limited;               //records thrown away by the rate limit
+} dlogTag_t;
+
+typedef struct {
+    const char *tag;
+    uint16_t perSec;
+    uint16_t burst;
+} dlogRate_t;
+
+static dlogRing_t dlogRings[portNUM_PROCESSORS];
+static dlogTag_t dlogTags[portNUM_PROCESSORS][DLOG_MAX_TAGS];
+static portMUX_TYPE dlogLock[portNUM_PROCESSORS] = {
+    [0 ... portNUM_PROCESSORS - 1] = portMUX_INITIALIZER_UNLOCKED };
+static dlogRate_t dlogRates[DLOG_MAX_TAGS];
+static uint8_t dlogNumRates;
+static uint32_t dlogSeq;
+static uint32_t dlogNoTag;          //records lost because the tag table was full
+static uint32_t dlogLost;           //drain side: total already reported
+
+static const char dlogLetter[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+
+//locked
+static dlogTag_t *dlogFindTag(int core, const char *tag){
+    dlogTag_t *t = dlogTags[core];
+
+    for(int i = 0; i < DLOG_MAX_TAGS; i++){
+        if(t[i].tag == tag) return &t[i];
+        if(t[i].tag) continue;
+
+        //first line of this tag on this core
+        t[i].perSec = DLOG_RATE;
+        t[i].burst = DLOG_BURST;
+        for(int r = 0; r < dlogNumRates; r++){
+            if(strcmp(dlogRates[r].tag, tag) == 0){
+                t[i].perSec = dlogRates[r].perSec;
+                t[i].burst = dlogRates[r].burst;
+            }
+        }
+        t[i].tokens = t[i].burst;
+        t[i].lastMs = esp_log_timestamp();
+        __atomic_store_n(&t[i].tag, tag, __ATOMIC_RELEASE);
+        return &t[i];
+    }
+    return NULL;
+}
+
+//locked. Take a token. The clock only moves forward by whole tokens, so slow
+//trickles refill too. 64 bits: days of silence times the rate don't fit in 32.
+static bool dlogAllow(dlogTag_t *t, uint32_t nowMs){
+    if(t->perSec){
+        uint64_t add = (uint64_t)(nowMs - t->lastMs) * t->perSec / 1000;
+        if(add >= (uint32_t)(t->burst - t->tokens)){
+            t->tokens = t->burst;
+            t->lastMs = nowMs;          //full, nothing to carry over
+        }else if(add){
+            t->lastMs += add * 1000 / t->perSec;
+            t->tokens += add;
+        }
+    }
+    if(t->tokens == 0){
+        t->limited++;
+        return false;
+    }
+    t->tokens--;
+    return true;
+}
+
+void dlogPut(uint8_t level, const char *tag, const char *fmt, int nargs, const uintptr_t *args){
+    int core = xPortGetCoreID();
+    dlogRing_t *ring = &dlogRings[core];
+    dlogTag_t *t;
+    uint32_t now, pos = 0, seq = 0;
+    bool ok;
+    dlogRec_t *r;
+
+    //time, slot and sequence number in one go: an ISR on this core that logs in
+    //between would otherwise sit after us in the ring with a lower seq (or time),
+    //and the drain's merge expects every ring in seq order
+    portENTER_CRITICAL_SAFE(&dlogLock[core]);
+    now = esp_log_timestamp();
+    t = dlogFindTag(core, tag);
+    ok = t && dlogAllow(t, now);
+    if(ok && __atomic_load_n(&ring->head, __ATOMIC_RELAXED) - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE)
+            >= DLOG_RING_LEN){
+        __atomic_fetch_add(&ring->full, 1, __ATOMIC_RELAXED);
+        ok = false;
+    }
+    if(ok){
+        pos = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+        seq = __atomic_fetch_add(&dlogSeq, 1, __ATOMIC_RELEASE);    //after head, see dlogDrain
+    }
+    portEXIT_CRITICAL_SAFE(&dlogLock[core]);
+    if(!t) __atomic_fetch_add(&dlogNoTag, 1, __ATOMIC_RELAXED);
+    if(!ok) return;
+
+    //claimed, publish it: the drain stops at it until level is set
+    r = &ring->rec[pos & (DLOG_RING_LEN - 1)];
+    r->seq = seq;
+    r->ms = now;
+    r->tag = tag;
+    r->fmt = fmt;
+    r->nargs = nargs;
+    for(int i = 0; i < nargs && i < DLOG_MAX_ARGS; i++) r->arg[i] = args[i];
+    __atomic_store_n(&r->level, level, __ATOMIC_RELEASE);
+}
+
+void dlogSetRate(const char *tag, uint16_t perSec, uint16_t burst){
+    if(dlogNumRates >= DLOG_MAX_TAGS) return;
+    dlogRates[dlogNumRates].tag = tag;
+    dlogRates[dlogNumRates].perSec = perSec;
+    dlogRates[dlogNumRates].burst = burst;
+    dlogNumRates++;
+}
+
+//oldest published record of a ring, NULL if empty or the next one is still being written
+static dlogRec_t *dlogPeek(dlogRing_t *ring, bool *stalled){
+    uint32_t tail = ring->tail;
+    dlogRec_t *r;
+
+    if(tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) return NULL;
+    r = &ring->rec[tail & (DLOG_RING_LEN - 1)];
+    if(__atomic_load_n(&r->level, __ATOMIC_ACQUIRE) == 0){
+        *stalled = true;
+        return NULL;
+    }
+    return r;
+}
+
+static void dlogFlush(char *buf, size_t *len){
+    if(*len){
+        fwrite(buf, 1, *len, stdout);
+        fflush(stdout);
+        *len = 0;
+    }
+}
+
+static void dlogAppend(char *buf, size_t *len, const char *line, int n){
+    if(n <= 0) return;
+    if(n >= DLOG_LINE) n = DLOG_LINE - 1;   //truncated by snprintf
+    if(*len + n > DLOG_BATCH) dlogFlush(buf, len);
+    memcpy(buf + *len, line, n);
+    *len += n;
+}
+
+//total of every kind of loss so far
+static uint32_t dlogDropped(void){
+    uint32_t sum = __atomic_load_n(&dlogNoTag, __ATOMIC_RELAXED);
+
+    for(int core = 0; core < portNUM_PROCESSORS; core++){
+        sum += __atomic_load_n(&dlogRings[core].full, __ATOMIC_RELAXED);
+        for(int i = 0; i < DLOG_MAX_TAGS; i++) sum += dlogTags[core][i].limited;
+    }
+    return sum;
+}
+
+void dlogDrain(void){
+    static char batch[DLOG_BATCH];
+    char line[DLOG_LINE];
+    size_t len = 0;
+    uint32_t lost, upTo;
+
+    //merge the per-core rings by sequence number. Stop at a record that is claimed
+    //but not written yet, anything after it would come out of order. Only records
+    //older than upTo: their slots are claimed before their seq is taken, so all of
+    //them are in the rings already. A newer one could be put in a ring already
+    //looked at while a later one shows up in the next ring.
+    upTo = __atomic_load_n(&dlogSeq, __ATOMIC_ACQUIRE);
+    while(1){
+        dlogRec_t *best = NULL;
+        dlogRing_t *from = NULL;
+        bool stalled = false;
+
+        for(int core = 0; core < portNUM_PROCESSORS; core++){
+            dlogRec_t *r = dlogPeek(&dlogRings[core], &stalled);
+            if(r && (!best || (int32_t)(r->seq - best->seq) < 0)){
+                best = r;
+                from = &dlogRings[core];
+            }
+        }
+        if(!best || stalled || (int32_t)(best->seq - upTo) >= 0) break;
+
+        int n = snprintf(line, sizeof(line), "%c (%u) %s: ",
+                         dlogLetter[best->level < sizeof(dlogLetter) ? best->level : 0], best->ms, best->tag);
+        //every argument goes in as a register sized word, which %d %u %x %c %s %p all read
+        n += snprintf(line + n, sizeof(line) - n, best->fmt,
+                      best->arg[0], best->arg[1], best->arg[2], best->arg[3]);
+        if(n >= (int)sizeof(line) - 1) n = sizeof(line) - 2;
+        line[n++] = '\n';
+        dlogAppend(batch, &len, line, n);
+
+        __atomic_store_n(&best->level, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&from->tail, from->tail + 1, __ATOMIC_RELEASE);
+    }
+
+    lost = dlogDropped();
+    if(lost != dlogLost){
+        int n = snprintf(line, sizeof(line), "W (%u) dlog: %u lines dropped\n",
+                         esp_log_timestamp(), lost - dlogLost);
+        dlogAppend(batch, &len, line, n);
+        dlogLost = lost;
+    }
+    dlogFlush(batch, &len);
+}
+
+void dlogTask(void * params){
+    uint8_t me = perfAddTask("dlog", NULL, true);
+    TickType_t wake = xTaskGetTickCount();
+
+    while(1){
+        vTaskDelayUntil(&wake, DLOG_DRAIN_MS / portTICK_PERIOD_MS);
+        PERF_RUN_TICK(me, wake);
+        dlogDrain();
+        PERF_IDLE(me);
+    }
+}
+
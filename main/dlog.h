@@ -0,0 +1,70 @@
+#ifndef _DLOG_H_
+#define _DLOG_H_
+
+//Deferred logging. DLOGI(TAG, "x %d", x) looks like ESP_LOGI but only stores the
+//format pointer and the raw arguments in this core's ring: no printf, no UART,
+//a few dozen bytes of stack, and it's fine from an ISR. The dlog task formats the
+//records in order and writes them out in batches.
+//
+//Limits: at most DLOG_MAX_ARGS arguments, integers, chars or pointers only (no
+//float, no 64-bit). %s must point at something that lives forever, like a literal.
+//Each tag gets DLOG_RATE lines per second (burst DLOG_BURST) per core, the rest
+//is counted and reported as dropped.
+//
+//Include it after esp_log.h and LOG_LOCAL_LEVEL, same filtering applies.
+
+#include <stdint.h>
+#include "esp_log.h"
+
+#define DLOG_MAX_ARGS  4
+#define DLOG_RING_LEN  64           //records per core between drains, power of 2
+#define DLOG_MAX_TAGS  8
+#define DLOG_RATE      20           //default lines per second per tag
+#define DLOG_BURST     10
+#define DLOG_DRAIN_MS  100
+
+typedef struct {
+    uint32_t seq;                   //global order across cores
+    uint32_t ms;
+    const char *tag;
+    const char *fmt;
+    uint8_t level;                  //0 = slot not written yet
+    uint8_t nargs;
+    uintptr_t arg[DLOG_MAX_ARGS];
+} dlogRec_t;
+
+//store one record, any context. Use the macros.
+void dlogPut(uint8_t level, const char *tag, const char *fmt, int nargs, const uintptr_t *args);
+
+//change the rate limit of one tag. Call before the tag's first line.
+void dlogSetRate(const char *tag, uint16_t perSec, uint16_t burst);
+
+//format and print everything stored so far, oldest first
+void dlogDrain(void);
+
+//drains every DLOG_DRAIN_MS, start it from the task table
+void dlogTask(void * params);
+
+//count the arguments (0..4) and widen each one to uintptr_t
+#define DLOG_N_(_0, _1, _2, _3, _4, N, ...) N
+#define DLOG_N(...) DLOG_N_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+#define DLOG_C0()
+#define DLOG_C1(a) (uintptr_t)(a)
+#define DLOG_C2(a, b) (uintptr_t)(a), (uintptr_t)(b)
+#define DLOG_C3(a, b, c) (uintptr_t)(a), (uintptr_t)(b), (uintptr_t)(c)
+#define DLOG_C4(a, b, c, d) (uintptr_t)(a), (uintptr_t)(b), (uintptr_t)(c), (uintptr_t)(d)
+#define DLOG_CAST(...) DLOG_N_(0, ##__VA_ARGS__, DLOG_C4, DLOG_C3, DLOG_C2, DLOG_C1, DLOG_C0)(__VA_ARGS__)
+
+#define DLOG_AT(level, tag, fmt, ...) do{ \
+        if(LOG_LOCAL_LEVEL >= (level)) \
+            dlogPut((level), (tag), (fmt), DLOG_N(__VA_ARGS__), \
+                    (const uintptr_t[]){ 0, DLOG_CAST(__VA_ARGS__) } + 1); \
+    }while(0)
+
+#define DLOGE(tag, fmt, ...) DLOG_AT(ESP_LOG_ERROR,   tag, fmt, ##__VA_ARGS__)
+#define DLOGW(tag, fmt, ...) DLOG_AT(ESP_LOG_WARN,    tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...) DLOG_AT(ESP_LOG_INFO,    tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...) DLOG_AT(ESP_LOG_DEBUG,   tag, fmt, ##__VA_ARGS__)
+#define DLOGV(tag, fmt, ...) DLOG_AT(ESP_LOG_VERBOSE, tag, fmt, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,30 @@
+//Flash device on an esp_partition, see flashDev.h
+
+#include "esp_partition.h"
+#include "esp_spi_flash.h"
+#include "flashDev.h"
+
+static bool partRead(const flashDev_t *dev, uint32_t addr, void *dst, uint32_t len){
+    return esp_partition_read(dev->ctx, addr, dst, len) == ESP_OK;
+}
+
+static bool partWrite(const flashDev_t *dev, uint32_t addr, const void *src, uint32_t len){
+    return esp_partition_write(dev->ctx, addr, src, len) == ESP_OK;
+}
+
+static bool partErase(const flashDev_t *dev, uint32_t addr){
+    return esp_partition_erase_range(dev->ctx, addr, dev->sectorSize) == ESP_OK;
+}
+
+bool flashDevPartition(flashDev_t *dev, const char *label){
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                            ESP_PARTITION_SUBTYPE_ANY, label);
+    if(!part) return false;
+    dev->size = part->size / SPI_FLASH_SEC_SIZE * SPI_FLASH_SEC_SIZE;
+    dev->sectorSize = SPI_FLASH_SEC_SIZE;
+    dev->read = partRead;
+    dev->write = partWrite;
+    dev->erase = partErase;
+    dev->ctx = part;
+    return true;
+}
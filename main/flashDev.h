@@ -0,0 +1,24 @@
+#ifndef _FLASHDEV_H_
+#define _FLASHDEV_H_
+
+//Raw NOR flash as the logs see it: read anywhere, write can only clear bits,
+//erase sets a whole sector back to 0xff. Addresses are relative to the device.
+//On the ESP32 it's a data partition; the host simulator fakes esp_partition
+//with a RAM or file image that can lose power in the middle of a write.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct flashDev {
+    uint32_t size;              //bytes, a whole number of sectors
+    uint32_t sectorSize;        //erase unit
+    bool (*read)(const struct flashDev *dev, uint32_t addr, void *dst, uint32_t len);
+    bool (*write)(const struct flashDev *dev, uint32_t addr, const void *src, uint32_t len);
+    bool (*erase)(const struct flashDev *dev, uint32_t addr);      //one sector
+    const void *ctx;
+} flashDev_t;
+
+//a data partition from partitions.csv, by label. False if there is none.
+bool flashDevPartition(flashDev_t *dev, const char *label);
+
+#endif
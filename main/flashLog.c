@@ -0,0 +1,182 @@
+//Flash ring log, see flashLog.h
+
+#include <stddef.h>
+#include <string.h>
+#include "crc32.h"
+#include "flashLog.h"
+
+#define FLASHLOG_MAGIC 0x31474c46      //"FLG1"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t sectorSeq;                 //1, 2, 3... never 0
+    uint32_t eraseCount;
+    uint32_t crc;
+} flashLogHdr_t;
+
+static bool logRead(flashLog_t *log, uint32_t addr, void *dst, uint32_t len){
+    log->reads++;
+    return log->dev->read(log->dev, addr, dst, len);
+}
+
+static uint32_t secAddr(const flashLog_t *log, int sector){
+    return (uint32_t)sector * log->dev->sectorSize;
+}
+
+static uint32_t slotAddr(const flashLog_t *log, int sector, int slot){
+    return secAddr(log, sector) + sizeof(flashLogHdr_t) + (uint32_t)slot * log->recSize;
+}
+
+//seq of a sector, 0 if erased, torn or never used. Fills *hdr if valid.
+static uint32_t secSeq(flashLog_t *log, int sector, flashLogHdr_t *hdr){
+    flashLogHdr_t h;
+
+    if(!logRead(log, secAddr(log, sector), &h, sizeof(h))) return 0;
+    if(h.magic != FLASHLOG_MAGIC || h.sectorSeq == 0 ||
+       h.crc != crc32Add(0, &h, offsetof(flashLogHdr_t, crc))) return 0;
+    if(hdr) *hdr = h;
+    return h.sectorSeq;
+}
+
+static bool slotBlank(flashLog_t *log, int sector, int slot){
+    uint32_t buf[(FLASHLOG_DATA_MAX + 8) / 4];
+
+    if(!logRead(log, slotAddr(log, sector, slot), buf, log->recSize)) return false;
+    for(int i = 0; i < log->recSize / 4; i++){
+        if(buf[i] != 0xffffffff) return false;
+    }
+    return true;
+}
+
+//valid record in a slot? Copies it to rec (seq, data, crc).
+static bool slotValid(flashLog_t *log, int sector, int slot, uint32_t *rec){
+    if(!logRead(log, slotAddr(log, sector, slot), rec, log->recSize)) return false;
+    return rec[0] != 0xffffffff &&
+           rec[log->recSize / 4 - 1] == crc32Add(0, rec, log->recSize - 4);
+}
+
+//records are written in slot order, so the used slots are a prefix: binary search its end
+static int firstBlank(flashLog_t *log, int sector){
+    int lo = 0, hi = log->perSector;
+
+    while(lo < hi){
+        int mid = (lo + hi) / 2;
+        if(slotBlank(log, sector, mid)) hi = mid;
+        else lo = mid + 1;
+    }
+    return lo;
+}
+
+//newest valid record of a sector below slot "end", -1 if none. A torn record
+//can only be the last one written, so this rarely steps back more than once.
+static int lastValid(flashLog_t *log, int sector, int end, uint32_t *rec){
+    while(end-- > 0){
+        if(slotValid(log, sector, end, rec)) return end;
+    }
+    return -1;
+}
+
+bool flashLogOpen(flashLog_t *log, const flashDev_t *dev, uint16_t dataLen, void *last, bool *found){
+    uint32_t rec[(FLASHLOG_DATA_MAX + 8) / 4];
+    flashLogHdr_t hdr;
+    uint32_t first, seq;
+    int lo, hi, prev;
+
+    memset(log, 0, sizeof(*log));
+    *found = false;
+    if(dataLen == 0 || dataLen > FLASHLOG_DATA_MAX || dev->sectorSize < 256) return false;
+    log->dev = dev;
+    log->dataLen = dataLen;
+    log->recSize = 4 + (dataLen + 3) / 4 * 4 + 4;
+    log->perSector = (dev->sectorSize - sizeof(flashLogHdr_t)) / log->recSize;
+    log->sectors = dev->size / dev->sectorSize;
+    log->seq = 1;
+    if(log->sectors < 2) return false;
+
+    //Sector seqs around the ring look like 5 6 7 3 4: rising, with one drop
+    //where the writer wrapped (an erased sector counts as 0 and can only be
+    //right after the newest). Find the first sector below sector 0's seq, the
+    //newest is just before it.
+    first = secSeq(log, 0, NULL);
+    lo = 1;
+    hi = log->sectors;
+    while(lo < hi){
+        int mid = (lo + hi) / 2;
+        if(secSeq(log, mid, NULL) < first) hi = mid;
+        else lo = mid + 1;
+    }
+    log->head = lo - 1;
+    seq = secSeq(log, log->head, &hdr);
+    if(seq == 0){
+        log->empty = true;              //never used, or only erased
+        return true;
+    }
+    log->sectorSeq = seq;
+    log->eraseCount = hdr.eraseCount;
+    log->slot = firstBlank(log, log->head);
+
+    //the newest sector may have no good record yet, then it's in the one before
+    if(lastValid(log, log->head, log->slot, rec) < 0){
+        prev = log->head ? log->head - 1 : log->sectors - 1;
+        if(secSeq(log, prev, NULL) != seq - 1 ||
+           lastValid(log, prev, firstBlank(log, prev), rec) < 0) return true;
+    }
+    memcpy(last, &rec[1], dataLen);
+    log->seq = rec[0] + 1;
+    *found = true;
+    return true;
+}
+
+//erase the next sector around the ring and put a header on it
+static bool nextSector(flashLog_t *log){
+    const flashDev_t *dev = log->dev;
+    flashLogHdr_t old, hdr;
+    int next = log->empty ? 0 : (log->head + 1) % log->sectors;
+
+    hdr.eraseCount = secSeq(log, next, &old) ? old.eraseCount + 1 : 1;
+    hdr.magic = FLASHLOG_MAGIC;
+    hdr.sectorSeq = log->empty ? 1 : log->sectorSeq + 1;
+    hdr.crc = crc32Add(0, &hdr, offsetof(flashLogHdr_t, crc));
+
+    log->erases++;
+    if(!dev->erase(dev, secAddr(log, next)) ||
+       !dev->write(dev, secAddr(log, next), &hdr, sizeof(hdr))) return false;
+    log->head = next;
+    log->slot = 0;
+    log->sectorSeq = hdr.sectorSeq;
+    log->eraseCount = hdr.eraseCount;
+    log->empty = false;
+    return true;
+}
+
+bool flashLogAppend(flashLog_t *log, const void *data){
+    uint32_t rec[(FLASHLOG_DATA_MAX + 8) / 4];
+    uint32_t back[(FLASHLOG_DATA_MAX + 8) / 4];
+    int words = log->recSize / 4;
+
+    if(!log->dev) return false;
+    memset(rec, 0, log->recSize);
+    rec[0] = log->seq;
+    memcpy(&rec[1], data, log->dataLen);
+    rec[words - 1] = crc32Add(0, rec, log->recSize - 4);
+
+    //a slot that doesn't read back right (worn bit, write error) is left
+    //behind, it fails its crc at the next boot. Try the next one.
+    for(int tries = 0; tries < 2; tries++){
+        uint32_t addr;
+        if((log->empty || log->slot >= log->perSector) && !nextSector(log)){
+            log->errors++;
+            return false;
+        }
+        addr = slotAddr(log, log->head, log->slot++);
+        if(log->dev->write(log->dev, addr, rec, log->recSize) &&
+           log->dev->read(log->dev, addr, back, log->recSize) &&
+           memcmp(rec, back, log->recSize) == 0){
+            log->seq++;
+            log->appends++;
+            return true;
+        }
+        log->errors++;
+    }
+    return false;
+}
@@ -0,0 +1,49 @@
+#ifndef _FLASHLOG_H_
+#define _FLASHLOG_H_
+
+//Append-only log of small fixed size records on a flashDev. Nothing is ever
+//rewritten: records fill a sector, then the log moves on to the next sector,
+//erasing the oldest one. Every sector gets erased once per lap, so the wear is
+//spread evenly without any bookkeeping.
+//
+//  sector: [header: magic, sector seq, erase count, crc][record][record]...
+//  record: [seq][data, padded to 4][crc]
+//
+//Opening finds the newest record without reading the whole device: sector seqs
+//go up around the ring, so a binary search over the headers finds the newest
+//sector, and records fill a sector in order, so a second binary search finds
+//the last one written. A record or header cut short by a power loss fails its
+//crc and is skipped.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "flashDev.h"
+
+#define FLASHLOG_DATA_MAX 32
+
+typedef struct {
+    const flashDev_t *dev;
+    uint16_t dataLen;
+    uint16_t recSize;           //bytes per record slot
+    uint16_t perSector;         //record slots per sector
+    uint16_t sectors;
+    uint16_t head;              //sector being filled
+    uint16_t slot;              //next free slot in it
+    bool empty;                 //no sector started yet
+    uint32_t sectorSeq;         //of the head sector
+    uint32_t eraseCount;        //of the head sector
+    uint32_t seq;               //number of the next record
+    uint32_t reads;             //flash reads so far, right after open that is the boot cost
+    uint32_t appends;
+    uint32_t erases;
+    uint32_t errors;            //failed or bad write-backs
+} flashLog_t;
+
+//open the log with "dataLen" bytes per record and copy the newest record into
+//"last". Sets *found if there was one. False if the device is unusable.
+bool flashLogOpen(flashLog_t *log, const flashDev_t *dev, uint16_t dataLen, void *last, bool *found);
+
+//add one record. Erases the oldest sector when the current one is full.
+bool flashLogAppend(flashLog_t *log, const void *data);
+
+#endif
@@ -0,0 +1,76 @@
+//Flow rate math, see flowCalc.h
+
+#include <string.h>
+#include "flowCalc.h"
+
+void flowCalcInit(flowCalc_t *fc, const flowCfg_t *cfg){
+    memset(fc, 0, sizeof(*fc));
+    fc->cfg = *cfg;
+    if(fc->cfg.window < 2) fc->cfg.window = 2;
+    if(fc->cfg.window > FLOW_WIN_MAX) fc->cfg.window = FLOW_WIN_MAX;
+}
+
+//add the pulses since the last sample to the volume. The remainder carries
+//over, so the total is exact however the pulses are split into samples.
+static void addVolume(flowCalc_t *fc, uint32_t pulses){
+    uint32_t kMilli = __atomic_load_n(&fc->cfg.kMilli, __ATOMIC_RELAXED);
+    uint64_t num;
+
+    num = (uint64_t)(pulses - fc->lastPulses) * 1000000 + fc->remMl;  //wraps correctly
+    fc->lastPulses = pulses;
+    if(kMilli == 0) return;
+    fc->totalMl += num / kMilli;
+    fc->remMl = num % kMilli;
+}
+
+void flowCalcAdd(flowCalc_t *fc, uint32_t pulses, uint64_t edgeUs, uint64_t nowUs, flowSnap_t *out){
+    const flowObs_t *old;
+    uint32_t edges, kMilli;
+    uint64_t dtUs;
+
+    fc->win[fc->head].pulses = pulses;
+    fc->win[fc->head].edgeUs = edgeUs;
+    fc->head = (fc->head + 1) % fc->cfg.window;
+    if(fc->n < fc->cfg.window) fc->n++;
+
+    //oldest sample still in the window
+    old = &fc->win[fc->n < fc->cfg.window ? 0 : fc->head];
+    edges = pulses - old->pulses;           //wraps correctly
+    dtUs = edgeUs - old->edgeUs;
+
+    addVolume(fc, pulses);
+    out->atUs = nowUs;
+    out->pulses = pulses;
+    out->totalMl = fc->totalMl;
+    out->rateMHz = 0;
+    out->flowMlMin = 0;
+
+    if(edges == 0 || dtUs == 0) return;
+    if(nowUs - edgeUs > fc->cfg.timeoutUs) return;     //stopped
+
+    //a pulse is overdue: the rate can't be higher than one pulse per time since the last
+    //one, so count that time in too. Makes the rate fall smoothly when flow stops.
+    if(nowUs - edgeUs > dtUs / edges) dtUs = nowUs - old->edgeUs;
+
+    out->rateMHz = (uint32_t)((uint64_t)edges * 1000000000ull / dtUs);
+    kMilli = __atomic_load_n(&fc->cfg.kMilli, __ATOMIC_RELAXED);
+    if(kMilli) out->flowMlMin = (uint32_t)((uint64_t)out->rateMHz * 60000 / kMilli);
+}
+
+void flowPublish(flowPub_t *pub, const flowSnap_t *snap){
+    uint32_t seq = pub->seq;
+    __atomic_store_n(&pub->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    pub->snap = *snap;
+    __atomic_store_n(&pub->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+void flowRead(const flowPub_t *pub, flowSnap_t *snap){
+    uint32_t before, after;
+    do{
+        before = __atomic_load_n(&pub->seq, __ATOMIC_ACQUIRE);
+        *snap = pub->snap;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&pub->seq, __ATOMIC_RELAXED);
+    }while((before & 1) || before != after);
+}
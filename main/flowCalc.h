@@ -0,0 +1,66 @@
+#ifndef _FLOWCALC_H_
+#define _FLOWCALC_H_
+
+//Flow rate math for the pulse sensor: integers only, no ESP-IDF includes,
+//so it runs the same on a PC as on the ESP32.
+//
+//The sampler feeds in the running pulse total and the time of the last pulse
+//every sample period. The rate is taken edge to edge over a moving window of
+//samples: (pulses in window) / (time between first and last edge in window).
+//That keeps full timer resolution even when only a few pulses come per sample.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FLOW_WIN_MAX 32
+
+typedef struct {
+    uint32_t kMilli;        //sensor K-factor in pulses per liter x 1000, 450000 = 450 p/L
+    uint32_t timeoutUs;     //no pulse for this long means the flow stopped
+    uint8_t window;         //samples in the moving window, 2..FLOW_WIN_MAX
+} flowCfg_t;
+
+//what other tasks read
+typedef struct {
+    uint64_t atUs;          //when this was computed
+    uint32_t pulses;        //running total since boot, wraps at 2^32
+    uint32_t rateMHz;       //pulse rate in milli-Hertz
+    uint32_t flowMlMin;     //flow in mL per minute
+    uint64_t totalMl;       //volume since boot in mL, never goes back
+} flowSnap_t;
+
+typedef struct {
+    uint32_t pulses;
+    uint64_t edgeUs;
+} flowObs_t;
+
+typedef struct {
+    flowCfg_t cfg;
+    flowObs_t win[FLOW_WIN_MAX];
+    uint8_t head;           //next slot to write
+    uint8_t n;              //slots filled
+    uint32_t lastPulses;    //pulse total of the previous sample
+    uint64_t totalMl;       //volume, added up one sample at a time
+    uint32_t remMl;         //what didn't make a whole mL yet, in mL x kMilli
+} flowCalc_t;
+
+//single writer, many readers, nobody waits: a sequence lock around one snapshot
+typedef struct {
+    uint32_t seq;           //odd while the writer is in the middle of an update
+    flowSnap_t snap;
+} flowPub_t;
+
+void flowCalcInit(flowCalc_t *fc, const flowCfg_t *cfg);
+
+//add one sample: running pulse total, time of the last pulse, and the time now.
+//Fills "out" with the new rate and totals. The pulse total may wrap, the volume
+//only grows by the pulses since the last sample, at the K-factor of the moment.
+void flowCalcAdd(flowCalc_t *fc, uint32_t pulses, uint64_t edgeUs, uint64_t nowUs, flowSnap_t *out);
+
+//writer side, one task only
+void flowPublish(flowPub_t *pub, const flowSnap_t *snap);
+
+//reader side, any task on any core. Retries if it raced the writer.
+void flowRead(const flowPub_t *pub, flowSnap_t *snap);
+
+#endif
@@ -0,0 +1,118 @@
+//Flow sensor input: count pulses in a GPIO ISR, turn them into a rate every sample period
+
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "flowCalc.h"
+#include "perfStats.h"
+#include "telemetry.h"
+#include "flowMeter.h"
+
+// Set the level before .h file
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+#define TAG "flowMeter"
+#include "dlog.h"
+
+
+#define FLOWpin GPIO_NUM_4
+
+//Each core counts into its own slot, so the ISR never shares a cache line or a
+//lock with the other core. The ISR does no math, just a count and a timestamp.
+typedef struct {
+    uint32_t seq;           //odd while the ISR is updating
+    uint32_t pulses;
+    uint64_t edgeUs;
+} __attribute__((aligned(32))) flowCount_t;
+
+static flowCount_t flowCount[portNUM_PROCESSORS];
+static flowCalc_t flowCalc;
+static flowPub_t flowPub;
+
+static flowCfg_t flowCfg = {
+    .kMilli = 450000,               //typical G1/2" hall sensor, 450 pulses per liter
+    .timeoutUs = 2000000,
+    .window = 10,                   //10 x 100 ms = 1 s moving window
+};
+
+//not instrumented with perfStats: at 10 kHz it would fill the event rings
+static void IRAM_ATTR flowISR(void *arg){
+    flowCount_t *c = &flowCount[xPortGetCoreID()];
+    __atomic_store_n(&c->seq, c->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    c->edgeUs = esp_timer_get_time();
+    c->pulses++;
+    __atomic_store_n(&c->seq, c->seq + 1, __ATOMIC_RELEASE);
+}
+
+//add up all cores. Re-read if an ISR came in between, so count and time match.
+static void flowCollect(uint32_t *pulses, uint64_t *edgeUs){
+    *pulses = 0;
+    *edgeUs = 0;
+    for(int i = 0; i < portNUM_PROCESSORS; i++){
+        flowCount_t *c = &flowCount[i];
+        uint32_t seq, p;
+        uint64_t t;
+        do{
+            seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+            p = c->pulses;
+            t = c->edgeUs;
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        }while((seq & 1) || seq != __atomic_load_n(&c->seq, __ATOMIC_RELAXED));
+        *pulses += p;
+        if(t > *edgeUs) *edgeUs = t;
+    }
+}
+
+//a task is passed one void pointer, returns void, but NEVER exits
+//samples the counters every FLOW_SAMPLE_MS and publishes a new snapshot.
+//The pulse ISR is hooked up from here, so it lands on the same core as this task.
+void flowTask(void * params){
+    TickType_t wake;
+    flowSnap_t snap;
+    uint32_t pulses;
+    uint64_t edgeUs;
+    bool flowing = false;
+    uint8_t me = perfAddTask("flow", NULL, true);
+
+    gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    gpio_isr_handler_add(FLOWpin, flowISR, NULL);
+    wake = xTaskGetTickCount();
+
+    while(1){
+        vTaskDelayUntil(&wake, FLOW_SAMPLE_MS / portTICK_PERIOD_MS);
+        PERF_RUN_TICK(me, wake);
+        flowCollect(&pulses, &edgeUs);
+        flowCalcAdd(&flowCalc, pulses, edgeUs, esp_timer_get_time(), &snap);
+        flowPublish(&flowPub, &snap);
+        telemPut(&snap);
+        if(flowing != (snap.flowMlMin != 0)){
+            flowing = !flowing;
+            if(flowing) DLOGI(TAG, "flow started, %u mL/min", snap.flowMlMin);
+            else DLOGI(TAG, "flow stopped, %u mL so far", (uint32_t)snap.totalMl);
+        }
+        PERF_IDLE(me);
+    }
+}
+
+//call first, then start flowTask (see the task table in main.c)
+void flowSetup(void){
+    flowCalcInit(&flowCalc, &flowCfg);
+
+    gpio_pad_select_gpio(FLOWpin);
+    gpio_set_direction(FLOWpin, GPIO_MODE_INPUT);
+    gpio_set_pull_mode(FLOWpin, GPIO_PULLUP_ONLY);  //sensors are open collector
+    gpio_set_intr_type(FLOWpin, GPIO_INTR_POSEDGE);
+}
+
+//change the K-factor (pulses per liter x 1000). Pulses from the next sample on count at the new
+//K, the volume so far stays as it is.
+void flowSetK(uint32_t kMilli){
+    __atomic_store_n(&flowCalc.cfg.kMilli, kMilli, __ATOMIC_RELAXED);
+}
+
+//latest rate and totals, any task, never blocks
+void flowGet(flowSnap_t *snap){
+    flowRead(&flowPub, snap);
+}
@@ -0,0 +1,21 @@
+#ifndef _FLOWMETER_H_
+#define _FLOWMETER_H_
+
+#include <stdint.h>
+#include "flowCalc.h"
+
+#define FLOW_SAMPLE_MS 100
+
+//call first
+void flowSetup(void);
+
+//samples the sensor every FLOW_SAMPLE_MS, start it from the task table
+void flowTask(void * params);
+
+//sensor K-factor in pulses per liter x 1000
+void flowSetK(uint32_t kMilli);
+
+//latest rate and totals, from any task, never blocks
+void flowGet(flowSnap_t *snap);
+
+#endif
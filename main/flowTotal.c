@@ -0,0 +1,83 @@
+//Lifetime flow total, checkpointed to flash, see flowTotal.h
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "flashDev.h"
+#include "flashLog.h"
+#include "flowMeter.h"
+#include "perfStats.h"
+#include "flowTotal.h"
+
+// Set the level before .h file
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+#define TAG "flowTotal"
+#include "dlog.h"
+
+//one checkpoint as stored in the log
+typedef struct {
+    uint64_t totalMl;
+} flowCkpt_t;
+
+static flashDev_t flowDev;
+static flashLog_t flowLog;
+static bool flowLogOk;
+static uint64_t baseMl;             //recovered at boot, read only after that
+
+uint64_t flowTotalMl(void){
+    flowSnap_t snap;
+    flowGet(&snap);
+    return baseMl + snap.totalMl;
+}
+
+//a task is passed one void pointer, returns void, but NEVER exits
+void flowTotalTask(void * params){
+    uint8_t me = perfAddTask("total", NULL, true);
+    flowSnap_t snap;
+    flowCkpt_t ckpt;
+    uint64_t saved = baseMl;
+    uint32_t ageMs = 0;
+    TickType_t wake = xTaskGetTickCount();
+
+    while(1){
+        vTaskDelayUntil(&wake, FLOW_TOTAL_MS / portTICK_PERIOD_MS);
+        PERF_RUN_TICK(me, wake);
+        flowGet(&snap);
+        ckpt.totalMl = baseMl + snap.totalMl;
+        ageMs += FLOW_TOTAL_MS;
+        //the volume only grows (flowCalc adds it up per sample), but a checkpoint
+        //below the last one would make that wrong for good: never write one
+        if(flowLogOk && ckpt.totalMl > saved &&
+           (ckpt.totalMl - saved >= FLOW_CKPT_ML || snap.flowMlMin == 0 || ageMs >= FLOW_CKPT_S * 1000)){
+            if(flashLogAppend(&flowLog, &ckpt)){
+                saved = ckpt.totalMl;
+                ageMs = 0;
+            }else{
+                DLOGW(TAG, "checkpoint of %u mL failed", (uint32_t)ckpt.totalMl);
+            }
+        }
+        PERF_IDLE(me);
+    }
+}
+
+//call after flowSetup(), then start flowTotalTask (see the task table in main.c)
+void flowTotalSetup(void){
+    flowCkpt_t last;
+    bool found;
+    int64_t t0 = esp_timer_get_time();
+
+    if(!flashDevPartition(&flowDev, FLOW_LOG_PART)){
+        ESP_LOGW(TAG, "no %s partition, the total won't survive a reboot", FLOW_LOG_PART);
+        return;
+    }
+    flowLogOk = flashLogOpen(&flowLog, &flowDev, sizeof(flowCkpt_t), &last, &found);
+    if(!flowLogOk){
+        ESP_LOGE(TAG, "can't use the %s partition", FLOW_LOG_PART);
+        return;
+    }
+    if(found) baseMl = last.totalMl;
+    ESP_LOGI(TAG, "%u mL from record %u, sector %u of %u, %u reads in %u us",
+             (uint32_t)baseMl, flowLog.seq - 1, flowLog.head, flowLog.sectors, flowLog.reads,
+             (uint32_t)(esp_timer_get_time() - t0));
+}
@@ -0,0 +1,25 @@
+#ifndef _FLOWTOTAL_H_
+#define _FLOWTOTAL_H_
+
+//Lifetime flow total that survives a reboot. The volume is checkpointed into a
+//flash ring log (flashLog.h) on the "flowlog" partition, not on every pulse:
+//after FLOW_CKPT_ML more mL, when the flow stops, or after FLOW_CKPT_S with
+//any change. A power loss costs at most that much volume.
+
+#include <stdint.h>
+
+#define FLOW_TOTAL_MS   1000        //how often the task looks at the total
+#define FLOW_CKPT_ML    1000
+#define FLOW_CKPT_S     60
+#define FLOW_LOG_PART   "flowlog"   //label in partitions.csv
+
+//call first, after flowSetup(): opens the log and recovers the total
+void flowTotalSetup(void);
+
+//checkpoints the total, start it from the task table
+void flowTotalTask(void * params);
+
+//volume since the log was new, in mL. Any task, never blocks.
+uint64_t flowTotalMl(void);
+
+#endif
@@ -7,7 +7,14 @@
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "outSched.h"
 #include "pinTasks.h"
+#include "flowMeter.h"
+#include "flowTotal.h"
+#include "perfStats.h"
+#include "taskTable.h"
+#include "telemetry.h"
+#include "dlog.h"
 
 // Set the level before .h file
 //#define LOG_LOCAL_LEVEL ESP_LOG_NONE
@@ -16,12 +23,32 @@
 #define TAG "inMain"
 
 
+//every task of the app. Budgets are worst case run times at TASK_BUDGET_MHZ (240),
+//keep them in line with the "run us" column of the perfStats table. The low
+//power profile's slower clock is scaled in by the check.
+const taskDef_t appTasks[] = {
+    //name      function        core             prio  stack  period ms        budget us
+    { "flow",   flowTask,       TASK_CORE_MEAS,   5,   2048,  FLOW_SAMPLE_MS,    200, NULL },
+    { "perf",   perfTask,       TASK_CORE_HOUSE,  2,   4096,  PERF_DRAIN_MS,    2000, NULL },
+    { "dlog",   dlogTask,       TASK_CORE_HOUSE,  2,   4096,  DLOG_DRAIN_MS,   10000, NULL },
+    { "telem",  telemTask,      TASK_CORE_HOUSE,  2,   3072,  FLOW_SAMPLE_MS,    500, NULL },  //woken by each sample
+    { "total",  flowTotalTask,  TASK_CORE_HOUSE,  1,   3072,  FLOW_TOTAL_MS,   50000, NULL },  //a sector erase is ~45 ms
+};
+const int appTaskCount = sizeof(appTasks) / sizeof(appTasks[0]);
+
+
 
 void app_main(void)
 {
     ESP_LOGI(TAG,"Starting...\n\n");
 	
-	LEDsetup();
+	perfSetup();    //first, so the others can register
+	outSetup();
+	LEDsetup();     //channel 0
+	flowSetup();
+	flowTotalSetup();
+	telemSetup();
+	taskTableBoot(appTasks, appTaskCount);
 	LEDblink(3);
 
     ESP_LOGI(TAG,"Goodbye world!\n");
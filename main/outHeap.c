@@ -0,0 +1,81 @@
+//Edge heap, see outHeap.h
+
+#include <string.h>
+#include "outHeap.h"
+
+static bool before(const outEdge_t *a, const outEdge_t *b){
+    if(a->at != b->at) return a->at < b->at;
+    if(a->prio != b->prio) return a->prio > b->prio;
+    return a->ch < b->ch;
+}
+
+static void put(outHeap_t *h, int i, const outEdge_t *e){
+    h->e[i] = *e;
+    h->pos[e->ch] = i + 1;
+}
+
+static void siftUp(outHeap_t *h, int i){
+    outEdge_t e = h->e[i];
+
+    while(i > 0){
+        int parent = (i - 1) / 2;
+        if(!before(&e, &h->e[parent])) break;
+        put(h, i, &h->e[parent]);
+        i = parent;
+    }
+    put(h, i, &e);
+}
+
+static void siftDown(outHeap_t *h, int i){
+    outEdge_t e = h->e[i];
+
+    while(1){
+        int child = 2 * i + 1;
+        if(child >= h->n) break;
+        if(child + 1 < h->n && before(&h->e[child + 1], &h->e[child])) child++;
+        if(!before(&h->e[child], &e)) break;
+        put(h, i, &h->e[child]);
+        i = child;
+    }
+    put(h, i, &e);
+}
+
+void outHeapInit(outHeap_t *h){
+    memset(h, 0, sizeof(*h));
+}
+
+void outHeapSet(outHeap_t *h, uint8_t ch, uint64_t at, uint8_t prio){
+    outEdge_t e = { .at = at, .prio = prio, .ch = ch };
+    int i;
+
+    if(ch >= OUT_MAX_CH) return;
+    if(h->pos[ch]){
+        i = h->pos[ch] - 1;
+        h->e[i] = e;
+    }else{
+        i = h->n++;
+        put(h, i, &e);
+    }
+    siftUp(h, i);
+    siftDown(h, h->pos[ch] - 1);
+}
+
+void outHeapRemove(outHeap_t *h, uint8_t ch){
+    uint8_t moved;
+    int i;
+
+    if(ch >= OUT_MAX_CH || !h->pos[ch]) return;
+    i = h->pos[ch] - 1;
+    h->pos[ch] = 0;
+    if(--h->n == i) return;         //it was the last one
+    moved = h->e[h->n].ch;          //the last one fills the hole
+    put(h, i, &h->e[h->n]);
+    siftUp(h, i);
+    siftDown(h, h->pos[moved] - 1);
+}
+
+bool outHeapPeek(const outHeap_t *h, outEdge_t *e){
+    if(h->n == 0) return false;
+    *e = h->e[0];
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef _OUTHEAP_H_
+#define _OUTHEAP_H_
+
+//Min-heap of the next edge of every output channel. Earliest first, and for
+//edges at the same time the higher priority channel first. A channel has at
+//most one edge queued, and it can be moved or taken out in O(log n).
+//Plain C, no ESP-IDF includes, so it builds and runs on a PC too.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef OUT_MAX_CH
+#define OUT_MAX_CH 16
+#endif
+
+typedef struct {
+    uint64_t at;            //timer count of the edge
+    uint8_t prio;           //higher goes first on a tie
+    uint8_t ch;
+} outEdge_t;
+
+typedef struct {
+    outEdge_t e[OUT_MAX_CH];
+    uint8_t pos[OUT_MAX_CH];        //index in e[] + 1, 0 = channel not queued
+    uint8_t n;
+} outHeap_t;
+
+void outHeapInit(outHeap_t *h);
+
+//queue the next edge of a channel, or move it if it was queued already
+void outHeapSet(outHeap_t *h, uint8_t ch, uint64_t at, uint8_t prio);
+
+//take a channel out, if it was queued
+void outHeapRemove(outHeap_t *h, uint8_t ch);
+
+//earliest edge, false if nothing is queued
+bool outHeapPeek(const outHeap_t *h, outEdge_t *e);
+
+#endif
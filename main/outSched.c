@@ -0,0 +1,215 @@
+//Output scheduler: many timed output channels on one hardware timer, see outSched.h
+
+#include <string.h>
+#include "driver/gpio.h"
+#include "driver/timer.h"
+#include "freertos/FreeRTOS.h"
+#include "perfStats.h"
+#include "outSched.h"
+
+//The edges are played by a hardware timer, not by vTaskDelay(). The tick would
+//round every edge to a tick and wake the scheduler twice per blink.
+//The timer counts microseconds and runs free, only its alarm is moved.
+#define OUT_TIMER_GROUP TIMER_GROUP_1
+#define OUT_TIMER       TIMER_0
+#define OUT_TIMER_DIV   80              //80 MHz APB / 80 = 1 us per count
+
+typedef struct {
+    gpio_num_t pin;
+    uint8_t prio;
+    bool busy;
+    outRefill_t refill;
+    blinkWave_t wave;
+    blinkSeq_t seq;
+} outChan_t;
+
+//Posters on either core and the ISR all go through outLock. Nothing in it
+//takes longer than a few heap steps per edge.
+static portMUX_TYPE outLock = portMUX_INITIALIZER_UNLOCKED;
+static outChan_t outChan[OUT_MAX_CH];
+static uint8_t outNumCh;
+static outHeap_t outHeap;
+static outStats_t outStats;
+static uint8_t perfId = PERF_NO_ID;
+
+static uint64_t outNow(void){
+    return timer_group_get_counter_value_in_isr(OUT_TIMER_GROUP, OUT_TIMER);
+}
+
+static void outLevel(outChan_t *c, uint32_t level){
+    if(c->pin != GPIO_NUM_NC) gpio_set_level(c->pin, level);
+}
+
+//locked. Compile a request onto the channel and rewind it, false if it's empty.
+static bool outLoad(outChan_t *c, const blinkReq_t *req){
+    if(!blinkCompile(req, &c->wave)) return false;
+    blinkSeqStart(&c->seq, &c->wave);
+    return true;
+}
+
+//locked. Ask the refill function until it gives something that compiles.
+static bool outRefill(int ch){
+    outChan_t *c = &outChan[ch];
+    blinkReq_t req;
+
+    while(c->refill && c->refill(ch, &req)){
+        if(outLoad(c, &req)) return true;
+    }
+    return false;
+}
+
+//locked. The channel's edge at "at" is due: put out the next segment and queue
+//the edge after it, or let the channel go idle.
+static void outStep(int ch, uint64_t at){
+    outChan_t *c = &outChan[ch];
+    blinkSeg_t seg;
+
+    if(!blinkSeqNext(&c->seq, &seg) && !(outRefill(ch) && blinkSeqNext(&c->seq, &seg))){
+        outLevel(c, 0);
+        c->busy = false;
+        outHeapRemove(&outHeap, ch);
+        return;
+    }
+    outLevel(c, seg.level);
+    outStats.edges++;
+    outHeapSet(&outHeap, ch, at + seg.durUs, c->prio);     //absolute, so edges never drift
+}
+
+//locked. Arm the alarm for "at". False if the counter got there first: the
+//alarm would never fire, the caller has to do the edge itself.
+static bool outAlarm(uint64_t at){
+    timer_group_set_alarm_value_in_isr(OUT_TIMER_GROUP, OUT_TIMER, at);
+    timer_group_enable_alarm_in_isr(OUT_TIMER_GROUP, OUT_TIMER);
+    return at > outNow();
+}
+
+//locked. Put out the edges that are due, then set the alarm on the next one.
+//After OUT_MAX_EDGES the rest waits for an interrupt right after this one, so
+//a backlog (the ISR held off by a flash erase, many channels due at once)
+//never keeps interrupts off for long. Edge times stay absolute, late edges
+//catch up without drift.
+//The counter is read again for every edge: a batch takes real time, more so
+//with a cold cache after a flash erase, and that is part of each edge's jitter.
+static void outService(void){
+    outEdge_t e;
+    uint64_t now;
+    int edges = 0;
+
+    while(outHeapPeek(&outHeap, &e)){
+        now = outNow();
+        if(e.at > now + OUT_SLACK_US){
+            if(outAlarm(e.at)) return;
+            continue;
+        }
+        if(edges++ == OUT_MAX_EDGES){
+            //"now" is fresh, so whatever this batch cost the alarm is ahead of the counter
+            outAlarm(now + OUT_SLACK_US);
+            return;
+        }
+        uint32_t jitter = now > e.at ? now - e.at : e.at - now;
+        outStats.jitterSumUs += jitter;
+        if(jitter > outStats.jitterMaxUs) outStats.jitterMaxUs = jitter;
+        outStep(e.ch, e.at);
+    }
+}
+
+//timer alarm: everything due goes out in this one interrupt
+static void outTimerISR(void *arg){
+    PERF_RUN(perfId);
+    portENTER_CRITICAL_ISR(&outLock);
+    timer_group_clr_intr_status_in_isr(OUT_TIMER_GROUP, OUT_TIMER);
+    outStats.wakeups++;
+    outService();
+    portEXIT_CRITICAL_ISR(&outLock);
+    PERF_IDLE(perfId);
+}
+
+static bool badCh(int ch){
+    return ch < 0 || ch >= outNumCh;
+}
+
+//locked. Start the channel's loaded wave with an edge right now.
+static void outStart(int ch){
+    outChan[ch].busy = true;
+    outHeapSet(&outHeap, ch, outNow(), outChan[ch].prio);
+    outService();
+}
+
+bool outPlay(int ch, const blinkReq_t *req){
+    bool ok;
+
+    if(badCh(ch)) return false;
+    portENTER_CRITICAL_SAFE(&outLock);
+    ok = outLoad(&outChan[ch], req);
+    if(ok) outStart(ch);
+    portEXIT_CRITICAL_SAFE(&outLock);
+    return ok;
+}
+
+void outKick(int ch){
+    if(badCh(ch)) return;
+    portENTER_CRITICAL_SAFE(&outLock);
+    if(!outChan[ch].busy && outRefill(ch)) outStart(ch);
+    portEXIT_CRITICAL_SAFE(&outLock);
+}
+
+void outCancel(int ch){
+    if(badCh(ch)) return;
+    portENTER_CRITICAL_SAFE(&outLock);
+    outHeapRemove(&outHeap, ch);
+    outChan[ch].busy = false;
+    outLevel(&outChan[ch], 0);
+    portEXIT_CRITICAL_SAFE(&outLock);
+}
+
+bool outBusy(int ch){
+    return !badCh(ch) && __atomic_load_n(&outChan[ch].busy, __ATOMIC_RELAXED);
+}
+
+void outGetStats(outStats_t *st){
+    portENTER_CRITICAL_SAFE(&outLock);
+    *st = outStats;
+    st->channels = outNumCh;
+    portEXIT_CRITICAL_SAFE(&outLock);
+}
+
+//call from setup code, before the channel is used
+int outAdd(gpio_num_t pin, uint8_t prio, outRefill_t refill){
+    outChan_t *c;
+    int ch;
+
+    portENTER_CRITICAL_SAFE(&outLock);
+    ch = outNumCh < OUT_MAX_CH ? outNumCh++ : -1;
+    portEXIT_CRITICAL_SAFE(&outLock);
+    if(ch < 0) return -1;
+
+    c = &outChan[ch];
+    c->pin = pin;
+    c->prio = prio;
+    c->refill = refill;
+    if(pin != GPIO_NUM_NC){
+        gpio_pad_select_gpio(pin);
+        gpio_set_direction(pin, GPIO_MODE_OUTPUT);
+        gpio_set_level(pin, 0);
+    }
+    return ch;
+}
+
+//call first, then outAdd() the channels
+void outSetup(void){
+    timer_config_t config = {
+        .divider = OUT_TIMER_DIV,
+        .counter_dir = TIMER_COUNT_UP,
+        .counter_en = TIMER_PAUSE,
+        .alarm_en = TIMER_ALARM_DIS,
+        .auto_reload = TIMER_AUTORELOAD_DIS,
+    };
+
+    outHeapInit(&outHeap);
+    perfId = perfAddIsr("out isr");
+    timer_init(OUT_TIMER_GROUP, OUT_TIMER, &config);
+    timer_set_counter_value(OUT_TIMER_GROUP, OUT_TIMER, 0);
+    timer_enable_intr(OUT_TIMER_GROUP, OUT_TIMER);
+    timer_isr_register(OUT_TIMER_GROUP, OUT_TIMER, outTimerISR, NULL, 0, NULL);
+    timer_start(OUT_TIMER_GROUP, OUT_TIMER);   //free running, only the alarm is switched
+}
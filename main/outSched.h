@@ -0,0 +1,58 @@
+#ifndef _OUTSCHED_H_
+#define _OUTSCHED_H_
+
+//All timed outputs (LEDs, relays, valves) on one hardware timer. Every channel
+//plays a blink pattern (blinkWave.h) on its pin. The next edge of each channel
+//sits in one heap (outHeap.h) and the timer alarm is set to the earliest, so
+//there is no task per output and only one interrupt per batch of edges.
+//Edges due within OUT_SLACK_US of each other go out in the same interrupt,
+//higher priority channels first.
+//
+//  outSetup();
+//  int valve = outAdd(GPIO_NUM_16, 2, NULL);
+//  outPlay(valve, &(blinkReq_t){ .count = 1, .onUs = 2000000, .repeat = 1 });
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "driver/gpio.h"
+#include "blinkWave.h"
+#include "outHeap.h"
+
+#define OUT_SLACK_US 50
+#define OUT_MAX_EDGES 32                //per interrupt, a backlog goes out over several
+
+//called when a channel's pattern ends, in the timer ISR or in the caller of
+//outKick(), with the scheduler locked: fill in the next request and return
+//true, or return false to let the channel go idle. Must not block.
+typedef bool (*outRefill_t)(int ch, blinkReq_t *req);
+
+typedef struct {
+    uint32_t channels;
+    uint64_t wakeups;               //timer interrupts
+    uint64_t edges;                 //segments started
+    uint64_t jitterSumUs;           //|time put out - time due|, summed over the edges
+    uint32_t jitterMaxUs;
+} outStats_t;
+
+//call first: sets up the timer
+void outSetup(void);
+
+//add a channel driving "pin" (GPIO_NUM_NC for none). Returns its number, -1 if
+//all OUT_MAX_CH are taken. "refill" may be NULL.
+int outAdd(gpio_num_t pin, uint8_t prio, outRefill_t refill);
+
+//drop whatever the channel plays and start this pattern now. Any context.
+//False if the request doesn't compile.
+bool outPlay(int ch, const blinkReq_t *req);
+
+//if the channel is idle, ask its refill function for something to play. Any context.
+void outKick(int ch);
+
+//stop the channel and set its pin low. It stays idle until the next outPlay() or outKick().
+void outCancel(int ch);
+
+bool outBusy(int ch);
+
+void outGetStats(outStats_t *st);
+
+#endif
@@ -0,0 +1,70 @@
+//Event ring and log2 histogram, see perfRing.h
+
+#include <string.h>
+#include "perfRing.h"
+
+//a writer can be interrupted between the full check and its claim, and the ISR
+//claims too. Keep a few slots spare so nested writers never lap the reader.
+#define PERF_RING_SPARE 4
+
+bool perfRingPush(perfRing_t *ring, uint32_t cycles, uint8_t type, uint8_t id, uint16_t arg){
+    uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    uint32_t pos;
+    perfEvt_t *e;
+
+    if(__atomic_load_n(&ring->head, __ATOMIC_RELAXED) - tail >= PERF_RING_LEN - PERF_RING_SPARE){
+        __atomic_fetch_add(&ring->drops, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    pos = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+    e = &ring->evt[pos & (PERF_RING_LEN - 1)];
+    e->cycles = cycles;
+    e->id = id;
+    e->arg = arg;
+    __atomic_store_n(&e->type, type, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool perfRingPop(perfRing_t *ring, perfEvt_t *evt){
+    uint32_t tail = ring->tail;
+    perfEvt_t *e;
+
+    if(tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) return false;
+    e = &ring->evt[tail & (PERF_RING_LEN - 1)];
+    evt->type = __atomic_load_n(&e->type, __ATOMIC_ACQUIRE);
+    if(evt->type == 0) return false;        //claimed, still being written
+    evt->cycles = e->cycles;
+    evt->id = e->id;
+    evt->arg = e->arg;
+    __atomic_store_n(&e->type, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void perfHistReset(perfHist_t *h){
+    memset(h, 0, sizeof(*h));
+    h->min = UINT32_MAX;
+}
+
+void perfHistAdd(perfHist_t *h, uint32_t val){
+    h->bin[val ? 32 - __builtin_clz(val) : 0]++;
+    h->count++;
+    h->sum += val;
+    if(val < h->min) h->min = val;
+    if(val > h->max) h->max = val;
+}
+
+uint32_t perfHistPercentile(const perfHist_t *h, int p){
+    uint64_t want = ((uint64_t)h->count * p + 99) / 100;
+    uint64_t seen = 0;
+
+    if(h->count == 0) return 0;
+    for(int i = 0; i < PERF_HIST_BINS; i++){
+        seen += h->bin[i];
+        if(seen >= want && seen){
+            uint32_t top = i >= 32 ? UINT32_MAX : (uint32_t)((1ull << i) - 1);
+            return top < h->max ? top : h->max;
+        }
+    }
+    return h->max;
+}
@@ -0,0 +1,50 @@
+#ifndef _PERFRING_H_
+#define _PERFRING_H_
+
+//Event ring and log2 histogram behind perfStats. Plain C, builds on a PC too.
+//
+//Each core writes its own ring, from tasks and ISRs alike; one reader drains
+//all rings. A slot is claimed with an atomic add and published by writing its
+//type last, so an ISR that interrupts a half-written event on the same core is fine.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PERF_RING_LEN   256         //events per core between drains, power of 2
+#define PERF_HIST_BINS  33          //bin i holds values with i significant bits
+
+typedef struct {
+    uint32_t cycles;                //CPU cycle counter of the core that wrote it
+    uint8_t type;                   //0 = slot not written yet
+    uint8_t id;
+    uint16_t arg;
+} perfEvt_t;
+
+typedef struct {
+    perfEvt_t evt[PERF_RING_LEN];
+    uint32_t head;                  //writers
+    uint32_t tail;                  //reader
+    uint32_t drops;
+} perfRing_t;
+
+typedef struct {
+    uint32_t bin[PERF_HIST_BINS];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} perfHist_t;
+
+//writer side, any context. False (and counted) if the ring is full.
+bool perfRingPush(perfRing_t *ring, uint32_t cycles, uint8_t type, uint8_t id, uint16_t arg);
+
+//reader side. False if there is nothing (finished) to read.
+bool perfRingPop(perfRing_t *ring, perfEvt_t *evt);
+
+void perfHistReset(perfHist_t *h);
+void perfHistAdd(perfHist_t *h, uint32_t val);
+
+//upper bound of the bin holding the p-th percentile (p in 0..100)
+uint32_t perfHistPercentile(const perfHist_t *h, int p);
+
+#endif
@@ -0,0 +1,268 @@
+//Task and ISR instrumentation, see perfStats.h
+
+#include <stdio.h>
+#include <string.h>
+#include "xtensa/core-macros.h"
+#include "esp_freertos_hooks.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "sdkconfig.h"
+#include "perfRing.h"
+#include "perfStats.h"
+
+#define PERF_MHZ CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ
+#define PERF_CAL_EVENTS 16
+
+//Cycle counters are per core and not in step with each other, so a run is only
+//paired with a wake or tick stamped on the same core. Tasks woken by other tasks
+//are often woken from the other core: their events are stamped with the shared
+//esp_timer instead, and the wake waits in wakeAt until the run pushes it.
+typedef struct {
+    const char *name;
+    TaskHandle_t task;              //NULL for ISRs
+    bool tickWoken;
+    bool woken;                     //stamped with the esp_timer, see perfStamp()
+    uint32_t wakeAt;                //first PERF_WAKE not yet run, 0 = none
+    uint32_t wakeCyc[portNUM_PROCESSORS];
+    uint32_t runCyc[portNUM_PROCESSORS];
+    bool wakePending[portNUM_PROCESSORS];
+    bool running[portNUM_PROCESSORS];
+    uint64_t busyCyc;
+    perfHist_t lat;                 //wake to run, cycles
+    perfHist_t run;                 //run to idle, cycles
+} perfId_t;
+
+typedef struct {
+    const char *name;
+    sigRing_t *ring;
+    QueueHandle_t q;
+    uint32_t hiWater;               //queues only, sampled at each drain
+} perfWatch_t;
+
+#define PERF_TICK_CYC (PERF_MHZ * 1000000 / configTICK_RATE_HZ)
+
+static perfRing_t perfRings[portNUM_PROCESSORS];
+static perfId_t perfIds[PERF_MAX_IDS];
+static uint8_t perfNumIds;
+static perfWatch_t perfWatch[PERF_MAX_WATCH];
+static uint8_t perfNumWatch;
+//written by the tick hooks, which stay on while the flash is busy: keep them out of it
+static DRAM_ATTR uint32_t tickCyc[portNUM_PROCESSORS];
+static DRAM_ATTR TickType_t tickNum[portNUM_PROCESSORS];
+static uint32_t lastTick[portNUM_PROCESSORS];    //drain side
+static bool tickSeen[portNUM_PROCESSORS];
+static int64_t perfSinceUs;
+static uint32_t perfEventCyc;       //measured cost of one perfEvent()
+
+//time stamp for an event of "id", in cycles
+static uint32_t perfStamp(uint8_t id){
+    if(id < PERF_MAX_IDS && perfIds[id].woken) return (uint32_t)(esp_timer_get_time() * PERF_MHZ);
+    return XTHAL_GET_CCOUNT();
+}
+
+void perfRunTick(uint8_t id, TickType_t due){
+    int core = xPortGetCoreID();
+    uint32_t now = XTHAL_GET_CCOUNT(), cyc, late;
+    TickType_t num;
+
+    //the tick hook may come in between, read until both are from the same tick
+    do{
+        num = __atomic_load_n(&tickNum[core], __ATOMIC_ACQUIRE);
+        cyc = __atomic_load_n(&tickCyc[core], __ATOMIC_ACQUIRE);
+    }while(num != __atomic_load_n(&tickNum[core], __ATOMIC_ACQUIRE));
+
+    //a run more than a tick late is measured from its due tick, not the last one
+    late = (int32_t)(num - due) > 0 ? num - due : 0;
+    perfRingPush(&perfRings[core], cyc, PERF_EV_TICK, PERF_NO_ID, late > 0xffff ? 0xffff : late);
+    perfRingPush(&perfRings[core], now, PERF_EV_RUN, id, 0);
+}
+
+void perfEvent(uint8_t type, uint8_t id){
+    int core = xPortGetCoreID();
+    uint32_t at, wake = 0;
+
+    //at 1000 Hz an event per tick would flood the rings, so the tick only stores
+    //its time and it goes into the ring just ahead of the run it woke
+    if(type == PERF_EV_RUN && id < PERF_MAX_IDS && perfIds[id].tickWoken){
+        perfRunTick(id, __atomic_load_n(&tickNum[core], __ATOMIC_ACQUIRE));
+        return;
+    }
+    at = perfStamp(id);
+    if(id < PERF_MAX_IDS && perfIds[id].woken){
+        if(type == PERF_EV_WAKE){  //keep the first wake, the run is late from that one
+            __atomic_compare_exchange_n(&perfIds[id].wakeAt, &wake, at ? at : 1, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+            return;
+        }
+        if(type == PERF_EV_RUN) wake = __atomic_exchange_n(&perfIds[id].wakeAt, 0, __ATOMIC_RELAXED);
+        if(wake) perfRingPush(&perfRings[core], wake, PERF_EV_WAKE, id, 0);
+    }
+    perfRingPush(&perfRings[core], at, type, id, 0);
+}
+
+static void IRAM_ATTR perfTickHook(void){
+    int core = xPortGetCoreID();
+    __atomic_store_n(&tickNum[core], xTaskGetTickCountFromISR(), __ATOMIC_RELEASE);
+    __atomic_store_n(&tickCyc[core], XTHAL_GET_CCOUNT(), __ATOMIC_RELEASE);
+}
+
+static uint8_t perfAdd(const char *name, TaskHandle_t task, bool tickWoken){
+    uint8_t id = __atomic_fetch_add(&perfNumIds, 1, __ATOMIC_RELAXED);
+    if(id >= PERF_MAX_IDS) return PERF_NO_ID;
+    perfIds[id].name = name;
+    perfIds[id].task = task;
+    perfIds[id].tickWoken = tickWoken;
+    perfIds[id].woken = task && !tickWoken;
+    perfHistReset(&perfIds[id].lat);
+    perfHistReset(&perfIds[id].run);
+    return id;
+}
+
+uint8_t perfAddTask(const char *name, TaskHandle_t task, bool tickWoken){
+    return perfAdd(name, task ? task : xTaskGetCurrentTaskHandle(), tickWoken);
+}
+
+uint8_t perfAddIsr(const char *name){
+    return perfAdd(name, NULL, false);
+}
+
+void perfWatchRing(const char *name, sigRing_t *ring){
+    if(perfNumWatch >= PERF_MAX_WATCH) return;
+    perfWatch[perfNumWatch].name = name;
+    perfWatch[perfNumWatch].ring = ring;
+    perfNumWatch++;
+}
+
+void perfWatchQueue(const char *name, QueueHandle_t q){
+    if(perfNumWatch >= PERF_MAX_WATCH) return;
+    perfWatch[perfNumWatch].name = name;
+    perfWatch[perfNumWatch].q = q;
+    perfNumWatch++;
+}
+
+static void perfHandle(int core, const perfEvt_t *e){
+    perfId_t *s;
+
+    if(e->type == PERF_EV_TICK){
+        lastTick[core] = e->cycles - (uint32_t)e->arg * PERF_TICK_CYC;   //back to the due tick
+        tickSeen[core] = true;
+        return;
+    }
+    if(e->id >= perfNumIds || e->id >= PERF_MAX_IDS) return;
+    s = &perfIds[e->id];
+
+    switch(e->type){
+    case PERF_EV_WAKE:
+        s->wakeCyc[core] = e->cycles;
+        s->wakePending[core] = true;
+        break;
+    case PERF_EV_RUN:
+        if(s->wakePending[core]) perfHistAdd(&s->lat, e->cycles - s->wakeCyc[core]);
+        else if(s->tickWoken && tickSeen[core]) perfHistAdd(&s->lat, e->cycles - lastTick[core]);
+        s->wakePending[core] = false;
+        s->runCyc[core] = e->cycles;
+        s->running[core] = true;
+        break;
+    case PERF_EV_IDLE:
+        if(!s->running[core]) break;
+        s->running[core] = false;
+        s->busyCyc += e->cycles - s->runCyc[core];
+        perfHistAdd(&s->run, e->cycles - s->runCyc[core]);
+        break;
+    }
+}
+
+void perfDrain(void){
+    perfEvt_t e;
+    for(int core = 0; core < portNUM_PROCESSORS; core++){
+        while(perfRingPop(&perfRings[core], &e)) perfHandle(core, &e);
+    }
+    for(int i = 0; i < perfNumWatch; i++){
+        if(perfWatch[i].q == NULL) continue;
+        uint32_t depth = uxQueueMessagesWaiting(perfWatch[i].q);
+        if(depth > perfWatch[i].hiWater) perfWatch[i].hiWater = depth;
+    }
+}
+
+void perfReset(void){
+    perfDrain();
+    for(int i = 0; i < perfNumIds && i < PERF_MAX_IDS; i++){
+        perfIds[i].busyCyc = 0;
+        perfHistReset(&perfIds[i].lat);
+        perfHistReset(&perfIds[i].run);
+    }
+    for(int core = 0; core < portNUM_PROCESSORS; core++) perfRings[core].drops = 0;
+    perfSinceUs = esp_timer_get_time();
+}
+
+#define US(cyc) ((cyc) / PERF_MHZ)
+
+void perfDump(void){
+    int64_t windowUs = esp_timer_get_time() - perfSinceUs;
+    uint32_t drops = 0;
+
+    for(int core = 0; core < portNUM_PROCESSORS; core++) drops += perfRings[core].drops;
+    printf("perf: %lld ms, %u cycles per event, %u events dropped\n",
+           (long long)(windowUs / 1000), perfEventCyc, drops);
+    printf("%-12s %8s %6s %21s %21s %7s\n", "name", "runs", "cpu%",
+           "lat us p50/p99/max", "run us p50/p99/max", "stack");
+
+    for(int i = 0; i < perfNumIds && i < PERF_MAX_IDS; i++){
+        perfId_t *s = &perfIds[i];
+        uint32_t permille = windowUs > 0 ? (uint32_t)(US(s->busyCyc) * 1000 / windowUs) : 0;
+        char lat[36] = "-", run[36] = "-", stack[12] = "isr";
+
+        if(s->lat.count) snprintf(lat, sizeof(lat), "%u/%u/%u", US(perfHistPercentile(&s->lat, 50)),
+                                  US(perfHistPercentile(&s->lat, 99)), US(s->lat.max));
+        if(s->run.count) snprintf(run, sizeof(run), "%u/%u/%u", US(perfHistPercentile(&s->run, 50)),
+                                  US(perfHistPercentile(&s->run, 99)), US(s->run.max));
+        if(s->task) snprintf(stack, sizeof(stack), "%u", uxTaskGetStackHighWaterMark(s->task));
+        printf("%-12s %8u %4u.%u %21s %21s %7s\n", s->name, s->run.count,
+               permille / 10, permille % 10, lat, run, stack);
+    }
+
+    for(int i = 0; i < perfNumWatch; i++){
+        perfWatch_t *w = &perfWatch[i];
+        if(w->ring){
+            printf("%-12s depth %u, high %u, merged %u, dropped %u\n", w->name, sigRingDepth(w->ring),
+                   w->ring->hiWater, w->ring->coalesced, w->ring->drops);
+        }else{
+            printf("%-12s depth %u, high %u\n", w->name, uxQueueMessagesWaiting(w->q), w->hiWater);
+        }
+    }
+}
+
+//a task is passed one void pointer, returns void, but NEVER exits
+//drains the rings and answers the console: 'p' prints, 'r' resets
+// printf needs the 4096 stack, see "stack" in the table
+void perfTask(void * params){
+    uint8_t me = perfAddTask("perf", NULL, true);
+    TickType_t wake = xTaskGetTickCount();
+
+    while(1){
+        vTaskDelayUntil(&wake, PERF_DRAIN_MS / portTICK_PERIOD_MS);
+        PERF_RUN_TICK(me, wake);
+        perfDrain();
+        switch(getchar()){          //console reads don't block, EOF if nothing came
+        case 'p': perfDump(); break;
+        case 'r': perfReset(); break;
+        default: clearerr(stdin);
+        }
+        PERF_IDLE(me);
+    }
+}
+
+//call first, before the other setups register, then start perfTask (see the task table in main.c)
+void perfSetup(void){
+    uint32_t t0;
+
+    //what does one event cost? Stamp a few into this core's ring, the drain skips them.
+    t0 = XTHAL_GET_CCOUNT();
+    for(int i = 0; i < PERF_CAL_EVENTS; i++) perfEvent(PERF_EV_NOP, PERF_NO_ID);
+    perfEventCyc = (XTHAL_GET_CCOUNT() - t0) / PERF_CAL_EVENTS;
+
+    for(int core = 0; core < portNUM_PROCESSORS; core++){
+        esp_register_freertos_tick_hook_for_cpu(perfTickHook, core);
+    }
+    perfSinceUs = esp_timer_get_time();
+}
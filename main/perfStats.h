@@ -0,0 +1,80 @@
+#ifndef _PERFSTATS_H_
+#define _PERFSTATS_H_
+
+//Measured, not guessed: wake-to-run latency, run time and CPU share per task or ISR,
+//stack high-water marks, and depth of the signal rings and queues.
+//
+//Call sites just drop a cycle-stamped event into their core's ring (perfRing.h).
+//A low priority task turns those into histograms every 100 ms, and prints the
+//table when you type 'p' on the console ('r' resets it).
+//
+//  uint8_t me = perfAddTask("flow", NULL, true);     //from inside the task
+//  while(1){ vTaskDelayUntil(&wake, ...); PERF_RUN_TICK(me, wake); ...work...; PERF_IDLE(me); }
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "sigRing.h"
+
+#define PERF_ENABLE 1               //0 compiles every PERF_ macro away
+
+#define PERF_MAX_IDS   12
+#define PERF_MAX_WATCH 6
+#define PERF_NO_ID     0xff
+#define PERF_DRAIN_MS  100
+
+enum {
+    PERF_EV_WAKE = 1,               //something made "id" ready to run
+    PERF_EV_RUN,                    //"id" started its work
+    PERF_EV_IDLE,                   //"id" finished and is about to block / return
+    PERF_EV_TICK,                   //last FreeRTOS tick on this core, ahead of a tick woken run.
+                                    //"arg" is how many ticks the run is late
+    PERF_EV_NOP,                    //calibration
+};
+
+//register a task. NULL = the calling task. "tickWoken" for tasks that sleep with
+//vTaskDelay/vTaskDelayUntil: their latency is measured from the tick that woke them.
+//Other tasks are measured from the first PERF_WAKE before their PERF_RUN, which
+//may come from either core.
+uint8_t perfAddTask(const char *name, TaskHandle_t task, bool tickWoken);
+
+//register an ISR, PERF_RUN on entry and PERF_IDLE on exit give its run time
+uint8_t perfAddIsr(const char *name);
+
+//report depth, high water and drops of a signal ring or a FreeRTOS queue
+void perfWatchRing(const char *name, sigRing_t *ring);
+void perfWatchQueue(const char *name, QueueHandle_t q);
+
+//call first: tick hooks and calibration
+void perfSetup(void);
+
+//drains the rings every PERF_DRAIN_MS and answers the console, start it from the task table
+void perfTask(void * params);
+
+//fold the rings into the statistics. The perf task does this, call it before perfDump() elsewhere.
+void perfDrain(void);
+void perfDump(void);
+void perfReset(void);
+
+//stamp an event on the calling core, any context. Use the macros.
+void perfEvent(uint8_t type, uint8_t id);
+
+//a tick woken task starts its work, "due" is the tick it should have woken on
+//(what vTaskDelayUntil() leaves in its wake time). PERF_RUN takes the last tick.
+void perfRunTick(uint8_t id, TickType_t due);
+
+#if PERF_ENABLE
+#define PERF_WAKE(id) perfEvent(PERF_EV_WAKE, (id))
+#define PERF_RUN(id)  perfEvent(PERF_EV_RUN, (id))
+#define PERF_IDLE(id) perfEvent(PERF_EV_IDLE, (id))
+#define PERF_RUN_TICK(id, due) perfRunTick((id), (due))
+#else
+#define PERF_WAKE(id) do{}while(0)
+#define PERF_RUN(id)  do{}while(0)
+#define PERF_IDLE(id) do{}while(0)
+#define PERF_RUN_TICK(id, due) do{ (void)(due); }while(0)
+#endif
+
+#endif
@@ -5,59 +5,104 @@
 #include "driver/gpio.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
+#include "blinkWave.h"
+#include "sigRing.h"
+#include "perfStats.h"
+#include "outSched.h"
+#include "pinTasks.h"
 
 // Set the level before .h file
 #define LOG_LOCAL_LEVEL ESP_LOG_INFO
 #include "esp_log.h"
 #define TAG "pinTasks"
+#include "dlog.h"
 
 
 //---------------------------- Control the LED(s) -----------------------------
 #define LEDdebug GPIO_NUM_2
-QueueHandle_t blinkAmtQ;
-
-//a task is passed one void pointer, returns void, but NEVER exits
-//this task waits for queue, gets count, and blinks
-// IF YOU USE ANY ESP_LOGI() THEN INCREASE TASK SIZE TO 4096! Else 1024.
-void LEDblinkTask(void * params){
-    int rxCount;
-    
-    // UBaseType_t uxHighWaterMark;
-    // /* Inspect our own high water mark on entering the task. */
-    // uxHighWaterMark = uxTaskGetStackHighWaterMark( NULL );
-    // ESP_LOGI(TAG,"High mark %d",uxHighWaterMark);
-    
-    while(1){
-        xQueueReceive(blinkAmtQ, &rxCount , portMAX_DELAY); //wait indefinitely for an rxCount from queue
-        //ESP_LOGI(TAG,"Do %d blinks.\n",rxCount);
-
-        while(rxCount--){
-            gpio_set_level(LEDdebug, 1);
-            vTaskDelay(500 / portTICK_PERIOD_MS);
-            gpio_set_level(LEDdebug, 0);
-            vTaskDelay(500 / portTICK_PERIOD_MS);
-        }
+#define LED_PRIO 0                      //status LED, anything else may go first
+
+//The debug LED is channel 0 of the output scheduler (outSched.h), which plays
+//the edges from its timer ISR. When a wave ends the ISR asks blinkRefill() for
+//the next request off blinkRing, so there is no blink task at all.
+
+//blinkRing carries plain counts from LEDblink(), or BLINK_SIG_PATTERN | slot
+//for a LEDpattern() request parked in patPool[slot]. Counts, merged ones too,
+//saturate at SIGRING_COUNT_MAX, so they never reach the flag bit.
+#define BLINK_RING_SLOTS  8
+#define BLINK_SIG_PATTERN (SIGRING_COUNT_MAX + 1)
+#define BLINK_PAT_SLOTS   4
+SIGRING_DEFINE(blinkRing, BLINK_RING_SLOTS);
+static blinkReq_t patPool[BLINK_PAT_SLOTS];
+static uint32_t patFree = (1u << BLINK_PAT_SLOTS) - 1;  //bit set = slot free
+static int ledCh = -1;
 
-    /* Calling the function will have used some stack space, we would 
-        therefore now expect uxTaskGetStackHighWaterMark() to return a 
-        value lower than when it was called on entering the task. */
-        // uxHighWaterMark = uxTaskGetStackHighWaterMark( NULL );
-        // ESP_LOGI(TAG,"High aftr %d",uxHighWaterMark);
+//refill of the LED channel, the scheduler lock makes us the only consumer of blinkRing
+static bool blinkRefill(int ch, blinkReq_t *req){
+    uint32_t sig;
+
+    if(!sigRingTake(&blinkRing, &sig)) return false;
+    if(sig & BLINK_SIG_PATTERN){
+        int slot = sig & ~BLINK_SIG_PATTERN;
+        *req = patPool[slot];
+        __atomic_fetch_or(&patFree, 1u << slot, __ATOMIC_RELEASE);
+    }else{
+        *req = (blinkReq_t){
+            .count = 1,                 //one blink, repeated, so any count fits in the wave
+            .onUs = 500000,
+            .offUs = 500000,
+            .gapUs = 0,
+            .repeat = sig,
+        };
     }
+    return true;
 }
 
-//call LEDsetup() first, then anyone can call LEDblink().
+//call LEDsetup() first, after outSetup(), then anyone can call LEDblink().
 void LEDsetup(void){
-    gpio_pad_select_gpio(LEDdebug);
-	gpio_set_direction(LEDdebug, GPIO_MODE_OUTPUT);
-    blinkAmtQ = xQueueCreate(3, sizeof(int)); //max 3 integers in queue
-    xTaskCreate(&LEDblinkTask, "blink LED", 1024, NULL, 2, NULL);
+    sigRingInit(&blinkRing, blinkRingSlots, BLINK_RING_SLOTS);
+    perfWatchRing("blinkRing", &blinkRing);
+    ledCh = outAdd(LEDdebug, LED_PRIO, blinkRefill);
 }
 
-//blink the debug LED "count" times. Do LEDsetup() first. Non-blocking, triggers task.
+//play any pattern on the debug LED. Do LEDsetup() first. Never blocks, OK from an ISR.
+//Returns false if the pattern doesn't compile or too many are already waiting.
+bool LEDpattern(const blinkReq_t *req){
+    uint32_t avail = __atomic_load_n(&patFree, __ATOMIC_ACQUIRE);
+    blinkWave_t wave;               //a few hundred bytes of stack, only to check
+    int slot;
+
+    //refuse it here, the refill would drop it without a word
+    if(!blinkCompile(req, &wave)) return false;
+    do{ //claim the lowest free slot
+        if(avail == 0){
+            __atomic_fetch_add(&blinkRing.drops, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+        slot = __builtin_ctz(avail);
+    }while(!__atomic_compare_exchange_n(&patFree, &avail, avail & ~(1u << slot), true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+    patPool[slot] = *req;
+    if(!sigRingTryPost(&blinkRing, BLINK_SIG_PATTERN | slot)){
+        __atomic_fetch_or(&patFree, 1u << slot, __ATOMIC_RELEASE);
+        return false;
+    }
+    outKick(ledCh);
+    return true;
+}
+
+//blink the debug LED "count" times, 500 ms on and 500 ms off. Never blocks, OK from an ISR.
+//Requests that find the ring full are merged with the pending count, never dropped.
 void LEDblink(int count){
-    //ESP_LOGI(TAG,"Request %d blinks.\n",count);
-    xQueueSend(blinkAmtQ, &count, 100 / portTICK_PERIOD_MS); //push count, if unsuccessful after 100 ms, ignore
+    DLOGI(TAG, "Request %d blinks.", count);
+    if(count <= 0) return;
+    sigRingPostCount(&blinkRing, count);
+    outKick(ledCh);
 }
 
+//how many blink requests were merged or dropped because the ring was full
+void LEDblinkStats(uint32_t *coalesced, uint32_t *drops){
+    *coalesced = __atomic_load_n(&blinkRing.coalesced, __ATOMIC_RELAXED);
+    *drops = __atomic_load_n(&blinkRing.drops, __ATOMIC_RELAXED);
+}
@@ -1,10 +1,23 @@
 #ifndef _PINTASKS_H_
 #define _PINTASKS_H_
 
-//call first
+#include <stdint.h>
+#include <stdbool.h>
+#include "blinkWave.h"
+
+//the debug LED, channel 0 of the output scheduler. Call after outSetup().
 void LEDsetup(void);
 
-//call after, whenever you wish, only 3 blink requests concurrently, else ignored
+//call after, whenever you wish, even from an ISR. Never blocks, counts that
+//arrive while the LED is busy are added up and blinked afterwards.
 void LEDblink(int count);
 
-#endif
\ No newline at end of file
+//same, but with your own on/off times, gap and repeat. See blinkWave.h
+//At most 4 patterns can wait at once. False if this one was dropped, or
+//blinkCompile() refuses it.
+bool LEDpattern(const blinkReq_t *req);
+
+//how many requests were merged into a pending count, or dropped
+void LEDblinkStats(uint32_t *coalesced, uint32_t *drops);
+
+#endif
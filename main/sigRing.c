@@ -0,0 +1,98 @@
+//Lock-free signal channel, see sigRing.h
+//Bounded MPSC ring in the style of D. Vyukov's queue: every slot carries a
+//sequence number, producers claim a slot with one compare-and-swap on "head"
+//and publish it by bumping the slot's sequence. The consumer never writes "head".
+
+#include "sigRing.h"
+
+void sigRingInit(sigRing_t *ring, sigSlot_t *slots, uint32_t n){
+    ring->slot = slots;
+    ring->mask = n - 1;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->pending = 0;
+    ring->posted = 0;
+    ring->coalesced = 0;
+    ring->drops = 0;
+    ring->hiWater = 0;
+    for(uint32_t i = 0; i < n; i++){
+        slots[i].seq = i;
+        slots[i].val = 0;
+    }
+}
+
+//claim a free slot and fill it, false if the ring is full
+static bool post(sigRing_t *ring, uint32_t val){
+    uint32_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    sigSlot_t *slot;
+
+    while(1){
+        slot = &ring->slot[pos & ring->mask];
+        int32_t dif = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if(dif == 0){
+            //slot is free for this lap, try to own it. On failure pos is reloaded.
+            if(__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        }else if(dif < 0){
+            return false;       //consumer hasn't freed it yet: full
+        }else{
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->val = val;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&ring->posted, 1, __ATOMIC_RELAXED);
+
+    //only for statistics, a lost race here just under-reports by one
+    uint32_t depth = pos + 1 - __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+    if(depth > __atomic_load_n(&ring->hiWater, __ATOMIC_RELAXED)) __atomic_store_n(&ring->hiWater, depth, __ATOMIC_RELAXED);
+    return true;
+}
+
+bool sigRingTryPost(sigRing_t *ring, uint32_t val){
+    if(post(ring, val)) return true;
+    __atomic_fetch_add(&ring->drops, 1, __ATOMIC_RELAXED);
+    return false;
+}
+
+void sigRingPostCount(sigRing_t *ring, uint32_t count){
+    uint32_t old, sum;
+
+    if(count > SIGRING_COUNT_MAX) count = SIGRING_COUNT_MAX;
+    if(post(ring, count)) return;
+    old = __atomic_load_n(&ring->pending, __ATOMIC_RELAXED);
+    do{ //saturating add, a merged total must never reach bit 31
+        sum = old + count;
+        if(sum > SIGRING_COUNT_MAX) sum = SIGRING_COUNT_MAX;
+    }while(!__atomic_compare_exchange_n(&ring->pending, &old, sum, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+    __atomic_fetch_add(&ring->coalesced, 1, __ATOMIC_RELAXED);
+}
+
+bool sigRingTake(sigRing_t *ring, uint32_t *val){
+    uint32_t pos = ring->tail;
+    sigSlot_t *slot = &ring->slot[pos & ring->mask];
+
+    //published slots have seq == pos + 1, anything else is empty or still being written
+    if(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) == pos + 1){
+        *val = slot->val;
+        __atomic_store_n(&slot->seq, pos + ring->mask + 1, __ATOMIC_RELEASE);  //free for next lap
+        __atomic_store_n(&ring->tail, pos + 1, __ATOMIC_RELAXED);
+        return true;
+    }
+
+    if(__atomic_load_n(&ring->pending, __ATOMIC_ACQUIRE) == 0) return false;
+    *val = __atomic_exchange_n(&ring->pending, 0, __ATOMIC_ACQ_REL);
+    return *val != 0;
+}
+
+bool sigRingEmpty(sigRing_t *ring){
+    uint32_t pos = ring->tail;
+    if(__atomic_load_n(&ring->slot[pos & ring->mask].seq, __ATOMIC_ACQUIRE) == pos + 1) return false;
+    return __atomic_load_n(&ring->pending, __ATOMIC_ACQUIRE) == 0;
+}
+
+uint32_t sigRingDepth(sigRing_t *ring){
+    return __atomic_load_n(&ring->head, __ATOMIC_RELAXED) - __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+}
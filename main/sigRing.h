@@ -0,0 +1,55 @@
+#ifndef _SIGRING_H_
+#define _SIGRING_H_
+
+//Lock-free signal channel: many producers, one consumer, 32-bit values.
+//Posting never blocks and never takes a lock, so it is fine from an ISR or
+//from either core. Plain C with GCC atomics, builds on a PC too.
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIGRING_COUNT_MAX 0x7fffffffu   //counts saturate here, bit 31 is free for the caller's flags
+
+typedef struct {
+    uint32_t seq;       //tells producers/consumer whose turn this slot is
+    uint32_t val;
+} sigSlot_t;
+
+typedef struct {
+    sigSlot_t *slot;
+    uint32_t mask;      //slots - 1
+    uint32_t head;      //next slot to fill (producers)
+    uint32_t tail;      //next slot to read (consumer only)
+    uint32_t pending;   //counts that found the ring full, summed up
+    uint32_t posted;    //values that went into a slot
+    uint32_t coalesced; //count posts folded into "pending"
+    uint32_t drops;     //values thrown away because the ring was full
+    uint32_t hiWater;   //most slots ever in use
+} sigRing_t;
+
+//static storage for a ring of "n" slots, n must be a power of 2. Still needs sigRingInit().
+#define SIGRING_DEFINE(name, n) \
+    static sigSlot_t name##Slots[n]; \
+    static sigRing_t name
+
+//n must be a power of 2
+void sigRingInit(sigRing_t *ring, sigSlot_t *slots, uint32_t n);
+
+//post one value. If the ring is full it is dropped, counted, and false is returned.
+bool sigRingTryPost(sigRing_t *ring, uint32_t val);
+
+//post a count. If the ring is full it is added to the pending total instead,
+//so counts are never lost, they just come out merged. Counts and the merged
+//total saturate at SIGRING_COUNT_MAX.
+void sigRingPostCount(sigRing_t *ring, uint32_t count);
+
+//consumer only. Gets the next value, then any merged count. False if there is nothing.
+bool sigRingTake(sigRing_t *ring, uint32_t *val);
+
+//consumer only. True if sigRingTake() would return nothing right now.
+bool sigRingEmpty(sigRing_t *ring);
+
+//values waiting (slots in use, a slot being written counts too)
+uint32_t sigRingDepth(sigRing_t *ring);
+
+#endif
@@ -0,0 +1,125 @@
+//Declarative task table, see taskTable.h
+
+#include <stdio.h>
+#include "taskTable.h"
+
+// Set the level before .h file
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+#define TAG "taskTable"
+
+#define TASK_MIN_STACK 1024
+
+//can a and b ever run on the same core?
+static bool shareCore(const taskDef_t *a, const taskDef_t *b){
+    return a->core == TASK_CORE_ANY || b->core == TASK_CORE_ANY || a->core == b->core;
+}
+
+static bool onCore(const taskDef_t *t, int core){
+    return t->core == TASK_CORE_ANY || t->core == core;
+}
+
+//budget at "mhz", rounded up
+static uint64_t budgetAt(const taskDef_t *t, int mhz){
+    return ((uint64_t)t->budgetUs * TASK_BUDGET_MHZ + mhz - 1) / mhz;
+}
+
+//worst case response time of tasks[i]: its budget plus every preemption by tasks
+//of equal or higher priority that can share its core. Does it fit in its period?
+static bool fitsPeriod(const taskDef_t *tasks, int n, int i, int mhz){
+    const taskDef_t *me = &tasks[i];
+    uint64_t limit = (uint64_t)me->periodMs * 1000;
+    uint64_t r = budgetAt(me, mhz), next;
+
+    while(1){
+        next = budgetAt(me, mhz);
+        for(int j = 0; j < n; j++){
+            const taskDef_t *o = &tasks[j];
+            if(j == i || o->periodMs == 0 || o->prio < me->prio || !shareCore(me, o)) continue;
+            uint64_t periodUs = (uint64_t)o->periodMs * 1000;
+            next += (r + periodUs - 1) / periodUs * budgetAt(o, mhz);
+        }
+        if(next > limit) return false;
+        if(next == r) return true;
+        r = next;
+    }
+}
+
+int taskTableCheck(const taskDef_t *tasks, int n, int cores, int mhz){
+    int problems = 0;
+
+    for(int i = 0; i < n; i++){
+        const taskDef_t *t = &tasks[i];
+        if(t->stack < TASK_MIN_STACK){
+            printf("task %s: stack %u is below %u\n", t->name, t->stack, TASK_MIN_STACK);
+            problems++;
+        }
+        if(t->prio >= configMAX_PRIORITIES){
+            printf("task %s: priority %u, max is %u\n", t->name, t->prio, configMAX_PRIORITIES - 1);
+            problems++;
+        }
+        if(t->core != TASK_CORE_ANY && (t->core < 0 || t->core >= cores)){
+            printf("task %s: core %d, this chip has %d\n", t->name, t->core, cores);
+            problems++;
+        }
+        if(t->periodMs == 0 && t->budgetUs){
+            //it would load its core and preempt others without ever being counted
+            printf("task %s: budget %u us but no period, give the shortest time between wakes\n",
+                   t->name, t->budgetUs);
+            problems++;
+        }
+        if(t->periodMs && budgetAt(t, mhz) > (uint64_t)t->periodMs * 1000){
+            printf("task %s: budget %u us at %d MHz is longer than its %u ms period\n",
+                   t->name, (uint32_t)budgetAt(t, mhz), mhz, t->periodMs);
+            problems++;
+        }
+    }
+
+    //rate monotonic: the more often a task runs, the higher its priority should be
+    for(int i = 0; i < n; i++){
+        for(int j = 0; j < n; j++){
+            const taskDef_t *a = &tasks[i], *b = &tasks[j];
+            if(!a->periodMs || !b->periodMs || !shareCore(a, b)) continue;
+            if(a->periodMs < b->periodMs && a->prio < b->prio){
+                printf("task %s (%u ms, prio %u) is below %s (%u ms, prio %u): priority inversion\n",
+                       a->name, a->periodMs, a->prio, b->name, b->periodMs, b->prio);
+                problems++;
+            }
+        }
+    }
+
+    //load per core. A task free to use either core is counted on both, worst case.
+    for(int core = 0; core < cores; core++){
+        uint32_t permille = 0;
+        for(int i = 0; i < n; i++){
+            const taskDef_t *t = &tasks[i];
+            if(t->periodMs && onCore(t, core)) permille += budgetAt(t, mhz) / t->periodMs;
+        }
+        if(permille > 1000){
+            printf("core %d: overcommitted, %u.%u%% of budget/period\n", core, permille / 10, permille % 10);
+            problems++;
+        }
+    }
+
+    for(int i = 0; i < n; i++){
+        if(tasks[i].periodMs && !fitsPeriod(tasks, n, i, mhz)){
+            printf("task %s: can miss its %u ms period behind higher priority tasks\n",
+                   tasks[i].name, tasks[i].periodMs);
+            problems++;
+        }
+    }
+    return problems;
+}
+
+int taskTableBoot(const taskDef_t *tasks, int n){
+    int problems = taskTableCheck(tasks, n, portNUM_PROCESSORS, CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ);
+
+    if(problems) ESP_LOGW(TAG, "%d problems in the task table, booting anyway", problems);
+    for(int i = 0; i < n; i++){
+        const taskDef_t *t = &tasks[i];
+        if(xTaskCreatePinnedToCore(t->fn, t->name, t->stack, NULL, t->prio, t->handle, t->core) != pdPASS){
+            ESP_LOGE(TAG, "could not create task %s", t->name);
+        }
+    }
+    return problems;
+}
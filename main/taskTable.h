@@ -0,0 +1,55 @@
+#ifndef _TASKTABLE_H_
+#define _TASKTABLE_H_
+
+//All app tasks in one table: where they run, how urgent, how big, how often and
+//how long. app_main boots the table, and the same table can be checked for
+//priority inversions and overloaded cores before it ever runs (g02sim -c).
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#define TASK_CORE_PRO 0
+#define TASK_CORE_APP 1
+#define TASK_CORE_ANY tskNO_AFFINITY
+
+//core for measurement tasks and for housekeeping, set by the profile in menuconfig
+#if defined(CONFIG_FREERTOS_UNICORE) || defined(CONFIG_G02_PROFILE_LOWPOWER)
+#define TASK_CORE_MEAS  TASK_CORE_PRO
+#else
+#define TASK_CORE_MEAS  TASK_CORE_APP
+#endif
+#define TASK_CORE_HOUSE TASK_CORE_PRO
+
+//the clock the budgets in a table are measured at. Checked at another clock they
+//are scaled, so one table serves every profile.
+#define TASK_BUDGET_MHZ 240
+
+typedef struct {
+    const char *name;
+    TaskFunction_t fn;
+    BaseType_t core;        //TASK_CORE_...
+    UBaseType_t prio;
+    uint32_t stack;         //bytes
+    uint32_t periodMs;      //period. A task woken by events: the shortest time between two wakes
+    uint32_t budgetUs;      //worst run time per period at TASK_BUDGET_MHZ, from perfStats
+    TaskHandle_t *handle;   //where to put the handle, may be NULL
+} taskDef_t;
+
+//the app's table, in main.c
+extern const taskDef_t appTasks[];
+extern const int appTaskCount;
+
+//check a table for a machine with "cores" cores at "mhz". Prints every problem, returns how many.
+//  - a shorter period with a lower priority on a shared core (rate monotonic inversion)
+//  - a core loaded over 100% by budget/period
+//  - a task that can miss its period once higher priority work is counted in
+//  - stacks, priorities or cores out of range, a budget with no period
+int taskTableCheck(const taskDef_t *tasks, int n, int cores, int mhz);
+
+//check, then create every task. Returns the number of problems found.
+int taskTableBoot(const taskDef_t *tasks, int n);
+
+#endif
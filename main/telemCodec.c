@@ -0,0 +1,178 @@
+//Telemetry packets, see telemCodec.h
+
+#include <string.h>
+#include "crc32.h"
+#include "telemCodec.h"
+
+#define TELEM_HDR 5
+
+//-------------------------------- varints ------------------------------------
+static uint8_t *putVar(uint8_t *p, uint64_t v){
+    while(v >= 0x80){
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static uint64_t zigzag(int64_t v){
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v){
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+//NULL if the varint runs past "end" or is too long
+static const uint8_t *getVar(const uint8_t *p, const uint8_t *end, uint64_t *v){
+    *v = 0;
+    for(int shift = 0; shift < 64 && p < end; shift += 7){
+        *v |= (uint64_t)(*p & 0x7f) << shift;
+        if(!(*p++ & 0x80)) return p;
+    }
+    return NULL;
+}
+
+//-------------------------------- encoder ------------------------------------
+void telemEncInit(telemEnc_t *e){
+    memset(e, 0, sizeof(*e));
+    e->len = TELEM_HDR;
+}
+
+bool telemEncAdd(telemEnc_t *e, const flowSnap_t *s){
+    uint8_t *p = &e->buf[e->len];
+
+    if(e->len + TELEM_SAMPLE_MAX > TELEM_PAYLOAD_MAX) return false;
+    p = putVar(p, s->atUs - e->prev.atUs);
+    p = putVar(p, zigzag((int64_t)s->pulses - e->prev.pulses));
+    p = putVar(p, zigzag((int64_t)s->rateMHz - e->prev.rateMHz));
+    p = putVar(p, zigzag((int64_t)s->flowMlMin - e->prev.flowMlMin));
+    p = putVar(p, zigzag((int64_t)(s->totalMl - e->prev.totalMl)));
+    e->len = p - e->buf;
+    e->count++;
+    e->prev = *s;
+    return true;
+}
+
+//COBS: every zero becomes the distance to the next one. Returns the length.
+static size_t cobs(const uint8_t *in, size_t len, uint8_t *out){
+    uint8_t *code = out, *o = out + 1;
+
+    for(size_t i = 0; i < len; i++){
+        if(in[i]){
+            *o++ = in[i];
+            if(o - code < 0xff) continue;
+        }
+        *code = o - code;
+        code = o++;
+    }
+    *code = o - code;
+    return o - out;
+}
+
+size_t telemEncFrame(telemEnc_t *e, uint8_t *out){
+    uint8_t payload[TELEM_PAYLOAD_MAX + 4];
+    uint32_t crc;
+    size_t n;
+
+    if(e->count == 0) return 0;
+    e->buf[0] = TELEM_VERSION;
+    e->buf[1] = e->session;
+    e->buf[2] = e->seq;
+    e->buf[3] = e->seq >> 8;
+    e->buf[4] = e->count;
+    memcpy(payload, e->buf, e->len);
+    crc = crc32Add(0, e->buf, e->len);
+    for(int i = 0; i < 4; i++) payload[e->len + i] = crc >> (8 * i);
+    n = cobs(payload, e->len + 4, out);
+    out[n++] = 0;
+
+    e->seq++;
+    e->len = TELEM_HDR;
+    e->count = 0;
+    memset(&e->prev, 0, sizeof(e->prev));
+    return n;
+}
+
+//-------------------------------- decoder ------------------------------------
+void telemDecInit(telemDec_t *d){
+    memset(d, 0, sizeof(*d));
+}
+
+//undo COBS in place, returns the decoded length or -1
+static int uncobs(uint8_t *buf, size_t len){
+    size_t i = 0, o = 0;
+
+    while(i < len){
+        uint8_t code = buf[i++];
+        if(code == 0 || i + code - 1 > len) return -1;
+        for(int k = 1; k < code; k++) buf[o++] = buf[i++];
+        if(code < 0xff && i < len) buf[o++] = 0;
+    }
+    return o;
+}
+
+static bool decodeFrame(telemDec_t *d, telemSampleFn fn, void *arg){
+    const uint8_t *p, *end;
+    flowSnap_t s;
+    uint64_t v[5];
+    uint16_t seq, gap;
+    uint32_t crc;
+    int n = uncobs(d->frame, d->len);
+
+    if(n < TELEM_HDR + 4) return false;
+    end = d->frame + n - 4;
+    crc = end[0] | end[1] << 8 | end[2] << 16 | (uint32_t)end[3] << 24;
+    if(crc != crc32Add(0, d->frame, n - 4) || d->frame[0] != TELEM_VERSION) return false;
+    seq = d->frame[2] | d->frame[3] << 8;
+
+    //a new session is a sender that started over, follow it whatever its seq.
+    //Else a small step forward is packets lost on the way. A small step back is
+    //a duplicate or a late packet: count it, but keep waiting for the next one.
+    //Anything else is a sender that started over too, follow it.
+    gap = seq - d->nextSeq;
+    if(d->haveSeq && d->frame[1] != d->session){
+        d->resync++;
+        d->nextSeq = seq + 1;
+    }else if(!d->haveSeq || gap < TELEM_SEQ_WINDOW){
+        if(d->haveSeq) d->lost += gap;
+        d->nextSeq = seq + 1;
+    }else{
+        d->resync++;
+        if(gap < 0x10000 - TELEM_SEQ_WINDOW) d->nextSeq = seq + 1;
+    }
+    d->haveSeq = true;
+    d->session = d->frame[1];
+    d->frames++;
+
+    memset(&s, 0, sizeof(s));
+    p = d->frame + TELEM_HDR;
+    for(int i = 0; i < d->frame[4]; i++){
+        for(int f = 0; f < 5; f++){
+            if(!(p = getVar(p, end, &v[f]))) return false;
+        }
+        s.atUs += v[0];
+        s.pulses += unzigzag(v[1]);
+        s.rateMHz += unzigzag(v[2]);
+        s.flowMlMin += unzigzag(v[3]);
+        s.totalMl += unzigzag(v[4]);
+        d->samples++;
+        if(fn) fn(arg, seq, &s);
+    }
+    return true;
+}
+
+void telemDecBytes(telemDec_t *d, const uint8_t *data, size_t len, telemSampleFn fn, void *arg){
+    for(size_t i = 0; i < len; i++){
+        uint8_t b = data[i];
+        if(b != 0){
+            if(d->len < sizeof(d->frame)) d->frame[d->len++] = b;
+            else d->overflow = true;
+            continue;
+        }
+        if(d->len && (d->overflow || !decodeFrame(d, fn, arg))) d->bad++;
+        d->len = 0;
+        d->overflow = false;
+    }
+}
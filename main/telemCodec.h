@@ -0,0 +1,73 @@
+#ifndef _TELEMCODEC_H_
+#define _TELEMCODEC_H_
+
+//Compact binary telemetry of flow samples. Plain C, no ESP-IDF includes, the
+//host decoder (host/tools/telemdec.c) builds this same file.
+//
+//A packet carries a few dozen samples. Each field is the difference to the
+//same field of the previous sample, as a zigzag varint, so a steady flow costs
+//about one byte per field. The first sample of a packet is sent against zero,
+//so every packet decodes on its own and a lost one costs only its samples.
+//
+//  payload: [version][session][seq lo][seq hi][count] sample... [crc32, little endian]
+//  sample:  dt us, d pulses, d rate mHz, d flow mL/min, d total mL
+//  frame:   COBS(payload) 0x00
+//
+//COBS leaves no zero bytes inside a frame, so a receiver that starts in the
+//middle or loses bytes is back in step at the next 0x00. The session byte is
+//random per boot: a sender that restarts is told apart from a late packet even
+//when its seq starts over close to where it was.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "flowCalc.h"
+
+#define TELEM_VERSION      2
+#ifndef TELEM_PAYLOAD_MAX
+#define TELEM_PAYLOAD_MAX  240
+#endif
+#define TELEM_SEQ_WINDOW   1024              //seq jumps up to this are lost packets
+#define TELEM_SAMPLE_MAX   50                //5 varints of at most 10 bytes
+#define TELEM_FRAME_MAX    (TELEM_PAYLOAD_MAX + 4 + TELEM_PAYLOAD_MAX / 254 + 2 + 1)
+
+typedef struct {
+    uint8_t buf[TELEM_PAYLOAD_MAX];
+    uint16_t len;
+    uint8_t count;
+    uint16_t seq;               //of the packet being built
+    uint8_t session;            //set after telemEncInit(), different on every boot
+    flowSnap_t prev;
+} telemEnc_t;
+
+typedef void (*telemSampleFn)(void *arg, uint16_t seq, const flowSnap_t *s);
+
+typedef struct {
+    uint8_t frame[TELEM_FRAME_MAX];
+    uint16_t len;
+    bool overflow;              //frame too long, skip to the next 0x00
+    bool haveSeq;
+    uint8_t session;
+    uint16_t nextSeq;
+    uint32_t frames;            //good packets
+    uint32_t bad;               //bad crc, length or version
+    uint32_t lost;              //packets missing from the seq numbers
+    uint32_t resync;            //sender restarted, or seq went back (duplicate, reordered) or jumped too far
+    uint32_t samples;
+} telemDec_t;
+
+void telemEncInit(telemEnc_t *e);
+
+//add a sample to the packet. False if it's full: frame it and add again.
+bool telemEncAdd(telemEnc_t *e, const flowSnap_t *s);
+
+//close the packet into "out" (TELEM_FRAME_MAX bytes) and start the next one.
+//Returns the frame length, 0 if there were no samples.
+size_t telemEncFrame(telemEnc_t *e, uint8_t *out);
+
+void telemDecInit(telemDec_t *d);
+
+//feed received bytes, "fn" gets every sample of every good packet
+void telemDecBytes(telemDec_t *d, const uint8_t *data, size_t len, telemSampleFn fn, void *arg);
+
+#endif
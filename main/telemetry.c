@@ -0,0 +1,99 @@
+//Telemetry task: flow samples into packets, packets out of a UART, see telemetry.h
+
+#include "driver/gpio.h"
+#include "driver/uart.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "perfStats.h"
+#include "telemCodec.h"
+#include "telemetry.h"
+
+// Set the level before .h file
+#define LOG_LOCAL_LEVEL ESP_LOG_INFO
+#include "esp_log.h"
+#define TAG "telemetry"
+#include "dlog.h"
+
+#define TELEM_UART       UART_NUM_1
+#define TELEM_TX_PIN     GPIO_NUM_17
+#define TELEM_BAUD       921600
+#define TELEM_TX_BUF     1024           //driver transmit buffer, bytes
+
+static QueueHandle_t telemQ;
+static telemEnc_t telemEnc;
+static uint8_t telemFrame[TELEM_FRAME_MAX];
+static uint32_t telemDrops;
+static uint8_t perfId = PERF_NO_ID;
+
+bool telemPut(const flowSnap_t *s){
+    PERF_WAKE(perfId);              //ahead of the send: the other core may run the task right away
+    if(telemQ && xQueueSend(telemQ, s, 0) == pdPASS) return true;
+    __atomic_fetch_add(&telemDrops, 1, __ATOMIC_RELAXED);
+    return false;
+}
+
+//close the packet and send it. Blocks while the transmit buffer is full, that's the backpressure.
+//The only place that knows about the UART: a socket would go here too.
+static void telemSend(void){
+    size_t n = telemEncFrame(&telemEnc, telemFrame);
+    if(n) uart_write_bytes(TELEM_UART, (const char *)telemFrame, n);
+}
+
+//a task is passed one void pointer, returns void, but NEVER exits
+void telemTask(void * params){
+    const TickType_t flush = TELEM_FLUSH_MS / portTICK_PERIOD_MS;
+    TickType_t opened = 0, wait;
+    uint32_t dropped = 0, drops;
+    flowSnap_t s;
+    bool got;
+
+    perfId = perfAddTask("telem", NULL, false);
+    while(1){
+        //sleep until a sample comes, or until the open packet is due
+        wait = portMAX_DELAY;
+        if(telemEnc.count){
+            TickType_t age = xTaskGetTickCount() - opened;
+            wait = age >= flush ? 0 : flush - age;
+        }
+        got = xQueueReceive(telemQ, &s, wait) == pdTRUE;
+        PERF_RUN(perfId);
+        if(got){
+            if(!telemEncAdd(&telemEnc, &s)){
+                telemSend();
+                telemEncAdd(&telemEnc, &s);
+            }
+            if(telemEnc.count == 1) opened = xTaskGetTickCount();
+        }
+        if(telemEnc.count && xTaskGetTickCount() - opened >= flush) telemSend();
+
+        drops = __atomic_load_n(&telemDrops, __ATOMIC_RELAXED);
+        if(drops != dropped){
+            DLOGW(TAG, "%u samples dropped, link too slow", drops - dropped);
+            dropped = drops;
+        }
+        PERF_IDLE(perfId);
+    }
+}
+
+//call first, then start telemTask (see the task table in main.c)
+void telemSetup(void){
+    uart_config_t cfg = {
+        .baud_rate = TELEM_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+    };
+
+    telemEncInit(&telemEnc);
+    telemEnc.session = esp_random();
+    telemQ = xQueueCreate(TELEM_QUEUE_LEN, sizeof(flowSnap_t));
+    perfWatchQueue("telemQ", telemQ);
+    //the driver wants an rx buffer bigger than the fifo, even if nothing comes in
+    ESP_ERROR_CHECK(uart_driver_install(TELEM_UART, 256, TELEM_TX_BUF, 0, NULL, 0));
+    ESP_ERROR_CHECK(uart_param_config(TELEM_UART, &cfg));
+    ESP_ERROR_CHECK(uart_set_pin(TELEM_UART, TELEM_TX_PIN, UART_PIN_NO_CHANGE,
+                                 UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+}
@@ -0,0 +1,27 @@
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+//Flow samples streamed as binary packets (telemCodec.h) on their own UART, so
+//the console stays readable and the link runs at 921600 baud instead of 115200.
+//Decode on a PC with host/build/telemdec.
+//
+//Backpressure: the telemetry task blocks when the UART's transmit buffer is
+//full, samples pile up in its queue, and once the queue is full telemPut()
+//drops them and counts. Whoever produces samples never waits.
+
+#include <stdbool.h>
+#include "flowCalc.h"
+
+#define TELEM_QUEUE_LEN  32             //samples
+#define TELEM_FLUSH_MS   1000           //longest a sample waits for its packet to fill
+
+//call first: UART and queue
+void telemSetup(void);
+
+//hand over a sample, any task. Never blocks, false if it was dropped.
+bool telemPut(const flowSnap_t *s);
+
+//packs and sends, start it from the task table
+void telemTask(void * params);
+
+#endif